@@ -0,0 +1,275 @@
+/**
+ * package.json parsing benchmark.
+ *
+ * Reads engines.node from a small manifest that declares it first, and from a large one that declares it after a big
+ * dependency table, once by parsing the whole document into a DOM like unvm used to, and once with FindJsonString.
+ * Both include opening and reading the file, like a launch does. Reports the time of each read as percentiles in JSON,
+ * and fails if the two ever disagree.
+ *
+ * Usage: unvm-json-bench [--iterations <n>] [--output <file>]
+ */
+
+#include <unvm/util.hxx>
+
+#include <json/json.hxx>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using clock_type = std::chrono::steady_clock;
+using reader_type = std::function<bool(const std::filesystem::path &, std::optional<std::string> &)>;
+
+struct Options
+{
+    size_t Iterations = 200;
+    size_t Warmup = 10;
+    std::filesystem::path Output;
+};
+
+struct Result
+{
+    std::string Manifest;
+    std::string Parser;
+    std::vector<double> Samples;
+};
+
+static void write_file(const std::filesystem::path &path, const std::string_view content)
+{
+    std::ofstream stream(path, std::ios::binary);
+    stream << content;
+}
+
+/**
+ * Write a package.json that declares its engine after a large dependency table, like the manifest scenario of the
+ * shim benchmark.
+ */
+static void write_large_manifest(const std::filesystem::path &path)
+{
+    std::string content = R"({"name":"large","dependencies":{)";
+
+    for (auto i = 0; i < 20000; ++i)
+    {
+        if (i)
+        {
+            content += ',';
+        }
+
+        content += R"("package-)" + std::to_string(i) + R"(":{"version":"^1.0.0","nested":[1,2,{"a":"b"}]})";
+    }
+
+    content += R"(},"engines":{"node":">=22"}})";
+
+    write_file(path, content);
+}
+
+/**
+ * The way read_package_version worked before FindJsonString.
+ */
+[[nodiscard]] static bool read_dom(const std::filesystem::path &path, std::optional<std::string> &version)
+{
+    std::ifstream stream(path);
+
+    json::Node node;
+    stream >> node;
+
+    return node && node["engines"]["node"] >> version;
+}
+
+[[nodiscard]] static bool read_scanner(const std::filesystem::path &path, std::optional<std::string> &version)
+{
+    std::ifstream stream(path, std::ios::binary);
+    return !!(unvm::FindJsonString(*stream.rdbuf(), { "engines", "node" }) >> version);
+}
+
+[[nodiscard]] static bool run(
+    const std::filesystem::path &path,
+    const reader_type &read,
+    const Options &options,
+    std::optional<std::string> &version,
+    std::vector<double> &samples)
+{
+    for (size_t i = 0; i < options.Warmup + options.Iterations; ++i)
+    {
+        const auto start = clock_type::now();
+
+        if (!read(path, version))
+        {
+            return false;
+        }
+
+        const auto sample = std::chrono::duration<double, std::micro>(clock_type::now() - start).count();
+
+        if (i >= options.Warmup)
+        {
+            samples.push_back(sample);
+        }
+    }
+
+    return true;
+}
+
+static double percentile(const std::vector<double> &sorted, const double p)
+{
+    const auto rank = static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+static void print_results(std::ostream &stream, const Options &options, std::vector<Result> &results)
+{
+    stream << "{\n";
+    stream << "  \"iterations\": " << options.Iterations << ",\n";
+    stream << "  \"unit\": \"us\",\n";
+    stream << "  \"results\": [";
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        auto &[manifest, parser, samples] = results[i];
+
+        std::ranges::sort(samples);
+
+        const auto mean = std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(samples.size());
+
+        stream << (i ? "," : "") << "\n    {";
+        stream << " \"manifest\": \"" << manifest << "\",";
+        stream << " \"parser\": \"" << parser << "\",";
+        stream << " \"samples\": " << samples.size() << ",";
+        stream << " \"min\": " << samples.front() << ",";
+        stream << " \"p50\": " << percentile(samples, 50) << ",";
+        stream << " \"p90\": " << percentile(samples, 90) << ",";
+        stream << " \"p99\": " << percentile(samples, 99) << ",";
+        stream << " \"max\": " << samples.back() << ",";
+        stream << " \"mean\": " << mean << " }";
+    }
+
+    stream << "\n  ]\n}" << std::endl;
+}
+
+[[nodiscard]] static bool parse_options(const int argc, char **argv, Options &options)
+{
+    for (auto i = 1; i < argc; ++i)
+    {
+        const std::string_view arg = argv[i];
+
+        if (arg == "--iterations" && i + 1 < argc)
+        {
+            options.Iterations = std::stoul(argv[++i]);
+        }
+        else if (arg == "--output" && i + 1 < argc)
+        {
+            options.Output = argv[++i];
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return options.Iterations;
+}
+
+int main(const int argc, char **argv)
+{
+    Options options;
+    if (!parse_options(argc, argv, options))
+    {
+        std::cerr << "usage: unvm-json-bench [--iterations <n>] [--output <file>]" << std::endl;
+        return 1;
+    }
+
+    std::string root_template = (std::filesystem::temp_directory_path() / "unvm-json-bench-XXXXXX").string();
+    if (!mkdtemp(root_template.data()))
+    {
+        std::cerr << "failed to create temporary directory." << std::endl;
+        return 1;
+    }
+
+    const std::filesystem::path root = root_template;
+
+    const std::pair<std::string, std::filesystem::path> manifests[]
+    {
+        { "small", root / "small.json" },
+        { "large", root / "large.json" },
+    };
+
+    write_file(manifests[0].second, R"({"name":"small","engines":{"node":">=22"},"dependencies":{"a":"^1.0.0"}})");
+    write_large_manifest(manifests[1].second);
+
+    const std::pair<std::string, reader_type> parsers[]
+    {
+        { "dom", read_dom },
+        { "scanner", read_scanner },
+    };
+
+    std::vector<Result> results;
+    auto ok = true;
+
+    for (auto &[manifest, path] : manifests)
+    {
+        std::optional<std::string> expected;
+        auto first = true;
+
+        for (auto &[parser, read] : parsers)
+        {
+            Result result{ .Manifest = manifest, .Parser = parser, .Samples = {} };
+
+            std::optional<std::string> version;
+            if (!run(path, read, options, version, result.Samples))
+            {
+                std::cerr << "parser '" << parser << "' failed for manifest '" << manifest << "'." << std::endl;
+                ok = false;
+                break;
+            }
+
+            if (!first && version != expected)
+            {
+                std::cerr << "parsers disagree on manifest '" << manifest << "'." << std::endl;
+                ok = false;
+                break;
+            }
+
+            expected = version;
+            first = false;
+
+            results.push_back(std::move(result));
+        }
+
+        if (!ok)
+        {
+            break;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::remove_all(root, ec);
+
+    if (!ok)
+    {
+        return 1;
+    }
+
+    if (options.Output.empty())
+    {
+        print_results(std::cout, options, results);
+        return 0;
+    }
+
+    std::ofstream stream(options.Output);
+    if (!stream)
+    {
+        std::cerr << "failed to open '" << options.Output.string() << "'." << std::endl;
+        return 1;
+    }
+
+    print_results(stream, options, results);
+    return 0;
+}
@@ -0,0 +1,598 @@
+/**
+ * Shim startup latency benchmark.
+ *
+ * Sets up a throwaway data directory with one fake installed version, whose node executable is this very binary (it
+ * exits immediately when started as 'node'). Then it launches the real unvm binary through 'node', 'npm' and 'npx'
+ * symlinks from a set of working directories, and reports the wall clock latency of each launch as percentiles in
+ * JSON, together with the peak resident set size of each launch. The 'direct' scenario starts the fake node executable
+ * without the shim, so the difference to it is the overhead of the shim. Pass unvm-shim instead of unvm to measure the
+ * standalone shim, which falls back to the unvm binary next to it. The 'contention' scenarios start N launches at
+ * once, the second one while a writer holds config.lock, as 'unvm use' does while it merges the config. Run them
+ * against builds before and after a change to compare how launches queue behind each other.
+ *
+ * Usage: unvm-bench <path to unvm> [--iterations <n>] [--concurrency <n>] [--output <file>]
+ */
+
+#if defined(SYSTEM_LINUX) || defined(SYSTEM_ANDROID) || defined(SYSTEM_DARWIN)
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#if defined(SYSTEM_DARWIN)
+
+#include <mach-o/dyld.h>
+
+#endif
+
+extern char **environ;
+
+using clock_type = std::chrono::steady_clock;
+
+// the newest version of the synthetic index, so the '>=22' ranges resolve to it and no launch offers to install one
+static constexpr auto version = "v22.20.2";
+static constexpr auto depth = 32;
+static constexpr auto lock_hold = std::chrono::milliseconds(20);
+
+struct Options
+{
+    std::filesystem::path Executable;
+    size_t Iterations = 200;
+    size_t Warmup = 10;
+    size_t Concurrency = 8;
+    std::filesystem::path Output;
+};
+
+struct Scenario
+{
+    std::string Name;
+    std::filesystem::path Directory;
+    std::vector<std::string> Shims;
+    bool Direct{};
+    bool Cold{};
+    bool Concurrent{};
+    bool Locked{};
+};
+
+struct Result
+{
+    std::string Scenario;
+    std::string Shim;
+    std::vector<double> Samples;
+    std::vector<double> Memory;
+};
+
+static void write_file(const std::filesystem::path &path, const std::string_view content)
+{
+    std::filesystem::create_directories(path.parent_path());
+
+    std::ofstream stream(path, std::ios::binary);
+    stream << content;
+}
+
+/**
+ * Write a synthetic index.json with entries for every platform, newest first like the upstream index.
+ */
+static void write_index(const std::filesystem::path &path)
+{
+    static constexpr auto files = R"(["linux-x64","linux-x86","linux-arm64","osx-x64-tar","osx-arm64-tar","win-x64-zip","win-x86-zip","win-arm64-zip"])";
+
+    std::string content = "[";
+
+    for (auto major = 22; major >= 0; --major)
+    {
+        for (auto minor = 20; minor >= 0; --minor)
+        {
+            for (auto patch = 2; patch >= 0; --patch)
+            {
+                if (content.size() > 1)
+                {
+                    content += ',';
+                }
+
+                content += R"({"version":"v)" + std::to_string(major) + '.' + std::to_string(minor) + '.'
+                        + std::to_string(patch) + R"(","date":"2024-01-01","files":)" + files
+                        + R"(,"npm":"10.0.0","v8":"12.0.0.0","uv":"1.48.0","zlib":"1.3.0","openssl":"3.0.13",)"
+                        + R"("modules":"127","lts":)" + (major % 2 ? "false" : "\"Codename\"")
+                        + R"(,"security":false})";
+            }
+        }
+    }
+
+    content += ']';
+
+    write_file(path, content);
+}
+
+/**
+ * Write a package.json that declares its engine after a large dependency table, so the whole manifest has to be
+ * scanned.
+ */
+static void write_large_manifest(const std::filesystem::path &path)
+{
+    std::string content = R"({"name":"large","dependencies":{)";
+
+    for (auto i = 0; i < 20000; ++i)
+    {
+        if (i)
+        {
+            content += ',';
+        }
+
+        content += R"("package-)" + std::to_string(i) + R"(":{"version":"^1.0.0","nested":[1,2,{"a":"b"}]})";
+    }
+
+    content += R"(},"engines":{"node":">=22"}})";
+
+    write_file(path, content);
+}
+
+/**
+ * Build the data directory, the shim directory and one working directory per scenario below root.
+ */
+static std::vector<Scenario> setup(
+    const std::filesystem::path &root,
+    const std::filesystem::path &self,
+    const Options &options)
+{
+    const auto data_directory = root / "config" / "unvm";
+    const auto shim_directory = root / "bin";
+    const auto work_directory = root / "work";
+
+    write_file(
+        data_directory / "config.json",
+        std::string(R"({"default":")") + version + R"(","installed":[")" + version + R"("],"fingerprints":[]})");
+
+    write_index(data_directory / "index.json");
+
+    const auto version_directory = data_directory / version;
+
+    std::filesystem::create_directories(version_directory / "bin");
+    std::filesystem::create_symlink(self, version_directory / "bin" / "node");
+
+    write_file(version_directory / "lib" / "node_modules" / "npm" / "bin" / "npm-cli.js", "");
+    write_file(version_directory / "lib" / "node_modules" / "npm" / "bin" / "npx-cli.js", "");
+
+    std::filesystem::create_directories(shim_directory);
+    for (const auto name : { "node", "npm", "npx" })
+    {
+        std::filesystem::create_symlink(options.Executable, shim_directory / name);
+    }
+
+    write_file(work_directory / "pin" / ".unvm", std::string(version) + '\n');
+    write_file(work_directory / "range" / "package.json", R"({"name":"range","engines":{"node":">=22"}})");
+    std::filesystem::create_directories(work_directory / "default");
+    write_large_manifest(work_directory / "manifest" / "package.json");
+
+    auto deep = work_directory / "deep";
+    write_file(deep / ".unvm", std::string(version) + '\n');
+    for (auto i = 0; i < depth; ++i)
+    {
+        deep /= "level-" + std::to_string(i);
+    }
+    std::filesystem::create_directories(deep);
+
+    const std::vector<std::string> all = { "node", "npm", "npx" };
+
+    return {
+        { .Name = "direct", .Directory = work_directory / "pin", .Shims = { "node" }, .Direct = true },
+        { .Name = "pin", .Directory = work_directory / "pin", .Shims = all },
+        { .Name = "range", .Directory = work_directory / "range", .Shims = all },
+        { .Name = "default", .Directory = work_directory / "default", .Shims = all },
+        { .Name = "deep", .Directory = deep, .Shims = all },
+        { .Name = "manifest", .Directory = work_directory / "manifest", .Shims = { "node" } },
+        { .Name = "pin-cold", .Directory = work_directory / "pin", .Shims = { "node" }, .Cold = true },
+        { .Name = "range-cold", .Directory = work_directory / "range", .Shims = { "node" }, .Cold = true },
+        { .Name = "contention", .Directory = work_directory / "pin", .Shims = { "node" }, .Concurrent = true },
+        {
+            .Name = "contention-locked",
+            .Directory = work_directory / "pin",
+            .Shims = { "node" },
+            .Concurrent = true,
+            .Locked = true,
+        },
+    };
+}
+
+/**
+ * Drop everything that is derived from config.json and index.json, so the next launch starts from scratch.
+ */
+static void make_cold(const std::filesystem::path &data_directory)
+{
+    std::error_code ec;
+    std::filesystem::remove(data_directory / "resolve.cache", ec);
+    std::filesystem::remove(data_directory / "index.bin", ec);
+}
+
+static std::filesystem::path get_self_path()
+{
+#if defined(SYSTEM_DARWIN)
+
+    char buffer[4096];
+    uint32_t size = sizeof(buffer);
+    if (_NSGetExecutablePath(buffer, &size))
+    {
+        return {};
+    }
+
+    return std::filesystem::canonical(buffer);
+
+#else
+
+    return std::filesystem::canonical("/proc/self/exe");
+
+#endif
+}
+
+[[nodiscard]] static bool spawn(const std::string &path, pid_t &pid)
+{
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    // a launch that prompts to install fails on the empty stdin, instead of waiting for the terminal
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+
+    char *argv[] = { const_cast<char *>(path.c_str()), const_cast<char *>("--version"), nullptr };
+
+    const auto error = posix_spawn(&pid, path.c_str(), &actions, nullptr, argv, environ);
+
+    posix_spawn_file_actions_destroy(&actions);
+
+    if (error)
+    {
+        std::cerr << "failed to spawn '" << path << "': " << std::strerror(error) << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Wait for a launch to exit, and get its peak resident set size in KiB. The peak survives exec, so it covers the shim
+ * as well as the executable it started.
+ */
+[[nodiscard]] static bool wait(const pid_t pid, double &memory)
+{
+    int status;
+    rusage usage{};
+    if (wait4(pid, &status, 0, &usage) < 0 || !WIFEXITED(status) || WEXITSTATUS(status))
+    {
+        std::cerr << "launch did not exit cleanly." << std::endl;
+        return false;
+    }
+
+#if defined(SYSTEM_DARWIN)
+    memory = static_cast<double>(usage.ru_maxrss) / 1024.0;
+#else
+    memory = static_cast<double>(usage.ru_maxrss);
+#endif
+
+    return true;
+}
+
+[[nodiscard]] static bool measure_one(const std::string &path, double &sample, double &memory)
+{
+    const auto begin = clock_type::now();
+
+    pid_t pid;
+    if (!spawn(path, pid) || !wait(pid, memory))
+    {
+        return false;
+    }
+
+    sample = std::chrono::duration<double, std::micro>(clock_type::now() - begin).count();
+    return true;
+}
+
+[[nodiscard]] static bool measure_concurrent(
+    const std::string &path,
+    const size_t count,
+    std::vector<double> &samples,
+    std::vector<double> &memory)
+{
+    std::vector<pid_t> pids(count);
+    std::vector<clock_type::time_point> begins(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        begins[i] = clock_type::now();
+        if (!spawn(path, pids[i]))
+        {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        double peak;
+        if (!wait(pids[i], peak))
+        {
+            return false;
+        }
+
+        memory.push_back(peak);
+
+        // reaping in spawn order may overstate early launches, but never understates any
+        samples.push_back(std::chrono::duration<double, std::micro>(clock_type::now() - begins[i]).count());
+    }
+
+    return true;
+}
+
+/**
+ * Take config.lock like a writer merging the config, and release it after lock_hold on another thread, while the
+ * launches are already running.
+ */
+[[nodiscard]] static bool hold_config_lock(const std::filesystem::path &data_directory, std::thread &thread)
+{
+    const auto handle = open((data_directory / "config.lock").c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0666);
+    if (handle < 0 || flock(handle, LOCK_EX))
+    {
+        std::cerr << "failed to lock the config." << std::endl;
+        if (handle >= 0)
+        {
+            close(handle);
+        }
+        return false;
+    }
+
+    thread = std::thread(
+        [handle]
+        {
+            std::this_thread::sleep_for(lock_hold);
+            flock(handle, LOCK_UN);
+            close(handle);
+        });
+
+    return true;
+}
+
+[[nodiscard]] static bool run(
+    const Scenario &scenario,
+    const std::string &path,
+    const std::filesystem::path &data_directory,
+    const Options &options,
+    std::vector<double> &samples,
+    std::vector<double> &memory)
+{
+    if (chdir(scenario.Directory.c_str()))
+    {
+        std::cerr << "failed to enter '" << scenario.Directory.string() << "'." << std::endl;
+        return false;
+    }
+
+    for (size_t i = 0; i < options.Warmup + options.Iterations; ++i)
+    {
+        if (scenario.Cold)
+        {
+            make_cold(data_directory);
+        }
+
+        std::vector<double> round;
+        std::vector<double> round_memory;
+
+        if (scenario.Concurrent)
+        {
+            std::thread writer;
+            if (scenario.Locked && !hold_config_lock(data_directory, writer))
+            {
+                return false;
+            }
+
+            const auto measured = measure_concurrent(path, options.Concurrency, round, round_memory);
+
+            if (writer.joinable())
+            {
+                writer.join();
+            }
+
+            if (!measured)
+            {
+                return false;
+            }
+        }
+        else if (double sample, peak; measure_one(path, sample, peak))
+        {
+            round.push_back(sample);
+            round_memory.push_back(peak);
+        }
+        else
+        {
+            return false;
+        }
+
+        if (i >= options.Warmup)
+        {
+            samples.insert(samples.end(), round.begin(), round.end());
+            memory.insert(memory.end(), round_memory.begin(), round_memory.end());
+        }
+    }
+
+    return true;
+}
+
+static double percentile(const std::vector<double> &sorted, const double p)
+{
+    const auto rank = static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+static void print_results(std::ostream &stream, const Options &options, std::vector<Result> &results)
+{
+    stream << "{\n";
+    stream << "  \"executable\": \"" << options.Executable.string() << "\",\n";
+    stream << "  \"iterations\": " << options.Iterations << ",\n";
+    stream << "  \"concurrency\": " << options.Concurrency << ",\n";
+    stream << "  \"unit\": \"us\",\n";
+    stream << "  \"results\": [";
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        auto &[scenario, shim, samples, memory] = results[i];
+
+        std::ranges::sort(samples);
+        std::ranges::sort(memory);
+
+        const auto mean = std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(samples.size());
+
+        stream << (i ? "," : "") << "\n    {";
+        stream << " \"scenario\": \"" << scenario << "\",";
+        stream << " \"shim\": \"" << shim << "\",";
+        stream << " \"samples\": " << samples.size() << ",";
+        stream << " \"min\": " << samples.front() << ",";
+        stream << " \"p50\": " << percentile(samples, 50) << ",";
+        stream << " \"p90\": " << percentile(samples, 90) << ",";
+        stream << " \"p99\": " << percentile(samples, 99) << ",";
+        stream << " \"max\": " << samples.back() << ",";
+        stream << " \"mean\": " << mean << ",";
+        stream << " \"rss_p50_kib\": " << percentile(memory, 50) << ",";
+        stream << " \"rss_max_kib\": " << memory.back() << " }";
+    }
+
+    stream << "\n  ]\n}" << std::endl;
+}
+
+[[nodiscard]] static bool parse_options(const int argc, char **argv, Options &options)
+{
+    for (auto i = 1; i < argc; ++i)
+    {
+        const std::string_view arg = argv[i];
+
+        if (arg == "--iterations" && i + 1 < argc)
+        {
+            options.Iterations = std::stoul(argv[++i]);
+        }
+        else if (arg == "--concurrency" && i + 1 < argc)
+        {
+            options.Concurrency = std::stoul(argv[++i]);
+        }
+        else if (arg == "--output" && i + 1 < argc)
+        {
+            options.Output = argv[++i];
+        }
+        else if (options.Executable.empty() && !arg.starts_with('-'))
+        {
+            options.Executable = arg;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return !options.Executable.empty() && options.Iterations && options.Concurrency;
+}
+
+int main(const int argc, char **argv)
+{
+    // started as the fake node executable of the installed version
+    if (std::filesystem::path(argv[0]).filename() == "node")
+    {
+        return 0;
+    }
+
+    Options options;
+    if (!parse_options(argc, argv, options))
+    {
+        std::cerr << "usage: unvm-bench <path to unvm> [--iterations <n>] [--concurrency <n>] [--output <file>]"
+                << std::endl;
+        return 1;
+    }
+
+    options.Executable = std::filesystem::absolute(options.Executable);
+
+    const auto self = get_self_path();
+
+    std::string root_template = (std::filesystem::temp_directory_path() / "unvm-bench-XXXXXX").string();
+    if (!mkdtemp(root_template.data()))
+    {
+        std::cerr << "failed to create temporary directory." << std::endl;
+        return 1;
+    }
+
+    const std::filesystem::path root = root_template;
+    const auto data_directory = root / "config" / "unvm";
+
+    const auto scenarios = setup(root, self, options);
+
+    // redirect the data directory of every launch into the throwaway tree
+    setenv("XDG_CONFIG_HOME", (root / "config").c_str(), 1);
+
+    std::vector<Result> results;
+    auto ok = true;
+
+    for (auto &scenario : scenarios)
+    {
+        for (auto &shim : scenario.Shims)
+        {
+            const auto path = scenario.Direct
+                                  ? (data_directory / version / "bin" / shim).string()
+                                  : (root / "bin" / shim).string();
+
+            Result result{ .Scenario = scenario.Name, .Shim = shim, .Samples = {}, .Memory = {} };
+            if (!run(scenario, path, data_directory, options, result.Samples, result.Memory))
+            {
+                std::cerr << "scenario '" << scenario.Name << "' failed for '" << shim << "'." << std::endl;
+                ok = false;
+                break;
+            }
+
+            results.push_back(std::move(result));
+        }
+
+        if (!ok)
+        {
+            break;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::remove_all(root, ec);
+
+    if (!ok)
+    {
+        return 1;
+    }
+
+    if (options.Output.empty())
+    {
+        print_results(std::cout, options, results);
+        return 0;
+    }
+
+    std::ofstream stream(options.Output);
+    if (!stream)
+    {
+        std::cerr << "failed to open '" << options.Output.string() << "'." << std::endl;
+        return 1;
+    }
+
+    print_results(stream, options, results);
+    return 0;
+}
+
+#else
+
+#include <iostream>
+
+int main()
+{
+    std::cerr << "the shim benchmark is only supported on posix systems." << std::endl;
+    return 1;
+}
+
+#endif
@@ -1,6 +1,10 @@
 set(BINARY_DIR "$ENV{DESTDIR}${CMAKE_INSTALL_PREFIX}/bin")
 file(MAKE_DIRECTORY "${BINARY_DIR}")
 
+if (NOT LINK_TARGET)
+    set(LINK_TARGET unvm)
+endif ()
+
 function (create_link name)
     if (WIN32)
         message(STATUS "creating hardlink for ${name}")
@@ -18,7 +22,7 @@ function (create_link name)
         message(STATUS "creating symlink for ${name}")
         execute_process(COMMAND
                 ${CMAKE_COMMAND} -E chdir ${BINARY_DIR}
-                ${CMAKE_COMMAND} -E create_symlink unvm ${name}
+                ${CMAKE_COMMAND} -E create_symlink ${LINK_TARGET} ${name}
             RESULT_VARIABLE result
         )
 
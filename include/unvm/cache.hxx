@@ -0,0 +1,85 @@
+#pragma once
+
+#include <unvm/util.hxx>
+
+#include <toolkit/result.hxx>
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace unvm
+{
+    constexpr auto ResolvedVariable = "UNVM_RESOLVED";
+
+    /**
+     * Cached outcome of resolving the active version for one directory. Version is the detected version spec, and
+     * Resolved the newest installed version matching it, if any. Direct is set if Resolved is also the version Execute
+     * would pick, i.e. no newer supported version matches, so a shim may run it without consulting the version table.
+     * All of them stay valid until one of the dependencies changes.
+     */
+    struct ResolutionEntry
+    {
+        std::optional<std::string> Version;
+        VersionType Type{};
+        std::optional<std::string> Resolved;
+        bool Direct{};
+        FileDependencies Dependencies;
+    };
+
+    /**
+     * On-disk cache of per-directory resolutions, stored as resolve.cache in the data directory. The whole cache is
+     * discarded as soon as the config or the version table change, individual entries as soon as any of the
+     * directories or marker files they were resolved from change.
+     */
+    class ResolutionCache
+    {
+    public:
+        static constexpr size_t Capacity = 256;
+
+        /**
+         * Read the cache from disk. A missing, malformed or outdated cache file results in an empty cache.
+         *
+         * @return
+         */
+        static ResolutionCache Open();
+
+        [[nodiscard]] bool Find(const std::filesystem::path &directory, ResolutionEntry &entry) const;
+        void Insert(const std::filesystem::path &directory, const ResolutionEntry &entry);
+
+        /**
+         * Write the cache back to disk, if it was modified. The file is replaced atomically, so concurrent processes
+         * only ever lose each other's additions, but never observe a partial cache.
+         *
+         * @return
+         */
+        [[nodiscard]] toolkit::result<> Save();
+
+    private:
+        std::filesystem::path m_Path;
+        std::string m_Header;
+        std::vector<std::string> m_Lines;
+        bool m_Dirty{};
+    };
+
+    /**
+     * Hand the resolution for the given directory down to child processes, through the UNVM_RESOLVED environment
+     * variable. The record holds the data directory, the state of the config and the version table, and everything
+     * the resolution depends on, so it is only ever taken over while all of them are unchanged.
+     *
+     * @param directory
+     * @param entry
+     */
+    void ExportResolution(const std::filesystem::path &directory, const ResolutionEntry &entry);
+
+    /**
+     * Take over the resolution exported by a parent process, if the given directory is the one it was made for, or
+     * below it without any marker file in between, and none of its dependencies changed since.
+     *
+     * @param directory
+     * @param entry
+     * @return
+     */
+    [[nodiscard]] bool ImportResolution(const std::filesystem::path &directory, ResolutionEntry &entry);
+}
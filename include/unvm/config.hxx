@@ -33,7 +33,8 @@ namespace unvm
     void MergeConfig(Config &dst, const Config &src);
 
     /**
-     * Read the config atomically from disk to the given memory reference.
+     * Read the config atomically from disk to the given memory reference. This takes no lock, but relies on writers
+     * replacing the file atomically.
      *
      * @param config
      * @return
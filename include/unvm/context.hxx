@@ -0,0 +1,95 @@
+#pragma once
+
+#include <unvm/config.hxx>
+#include <unvm/lookup.hxx>
+#include <unvm/util.hxx>
+#include <unvm/version.hxx>
+#include <unvm/http/http.hxx>
+
+#include <toolkit/result.hxx>
+
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace unvm
+{
+    /**
+     * Per-process resolution state shared by main() and all commands. The version table is loaded at most once per
+     * mode (offline, then online if needed), the supported and installed views of it and their lookup indexes are
+     * built on first use, and every FindVersionEntry result is memoized per view. Both views share the one loaded
+     * table, so switching between them never reloads or copies it.
+     *
+     * Views returned by Table stay valid until the table is reloaded online or, for the installed view, Invalidate is
+     * called. Entries returned by Find stay valid until the table is reloaded online.
+     */
+    class ResolutionContext
+    {
+    public:
+        ResolutionContext(const Config &config, http::HttpClient &client);
+
+        [[nodiscard]] http::HttpClient &Client() const;
+
+        /**
+         * Get the supported entries of the version table, optionally restricted to installed versions. If online is
+         * set, the table is refreshed from the network once if the cached copy is stale.
+         *
+         * @param online
+         * @param installed
+         * @return
+         */
+        [[nodiscard]] toolkit::result<const VersionView *> Table(bool online, bool installed);
+
+        /**
+         * Memoized FindVersionEntry on the view selected by online and installed.
+         *
+         * @param version
+         * @param online
+         * @param installed
+         * @return
+         */
+        [[nodiscard]] toolkit::result<VersionEntry> Find(std::string_view version, bool online, bool installed);
+
+        /**
+         * Memoized FindActiveVersion for the current directory.
+         *
+         * @param type
+         * @return
+         */
+        [[nodiscard]] toolkit::result<std::optional<std::string>> ActiveVersion(VersionType *type = {});
+
+        /**
+         * Record the active version if it was already detected by other means, e.g. from the resolution cache.
+         *
+         * @param version
+         * @param type
+         */
+        void SetActiveVersion(std::optional<std::string> version, VersionType type);
+
+        /**
+         * Drop everything derived from the installed versions. Must be called whenever the installed set of the
+         * config changes.
+         */
+        void Invalidate();
+
+    private:
+        const Config &m_Config;
+        http::HttpClient &m_Client;
+
+        std::shared_ptr<const VersionTable> m_Table;
+        std::optional<VersionView> m_Supported;
+        std::optional<VersionView> m_Installed;
+        VersionLookup m_SupportedLookup;
+        VersionLookup m_InstalledLookup;
+        bool m_Online{};
+
+        std::map<std::pair<bool, std::string>, VersionEntry> m_Entries;
+
+        bool m_HasActive{};
+        std::optional<std::string> m_Active;
+        VersionType m_ActiveType{};
+    };
+}
@@ -4,6 +4,7 @@
 
 #include <toolkit/result.hxx>
 
+#include <filesystem>
 #include <format>
 #include <map>
 #include <span>
@@ -127,6 +128,15 @@ namespace unvm::http
         std::string &status_message);
     void ParseHeaders(std::istream &stream, HttpHeaders &headers);
 
+    /**
+     * Point a URL at the target of a location header, which is either absolute, or relative to the host or the path of
+     * the URL.
+     *
+     * @param url
+     * @param location
+     */
+    void ApplyLocation(URL &url, const std::string &location);
+
     struct HttpTransport
     {
         virtual ~HttpTransport() = default;
@@ -135,19 +145,57 @@ namespace unvm::http
         virtual int read(std::span<char> buffer) = 0;
     };
 
+    /**
+     * HTTP/1.1 client that keeps connections alive between fetches. Fetches may be made from several threads at once.
+     */
     class HttpClient
     {
     public:
+        /**
+         * Client that trusts the bundled vendor certificates.
+         */
         HttpClient();
+        /**
+         * Client that trusts the given PEM certificates instead of the bundled ones, e.g. the CA of a local test
+         * server. The buffer must stay valid for as long as the client lives.
+         *
+         * @param certificates
+         */
+        explicit HttpClient(std::span<const uint8_t> certificates);
         ~HttpClient();
 
         [[nodiscard]] toolkit::result<> Fetch(HttpRequest request, HttpResponse &response) const;
         [[nodiscard]] toolkit::result<> FetchWithRedirects(HttpRequest request, HttpResponse &response) const;
 
     private:
+        /**
+         * Create the TLS context and load the trusted certificates on first use, so clients that never fetch over https
+         * do not pay for parsing the certificate bundle. The context is kept for all further fetches.
+         *
+         * @return
+         */
+        [[nodiscard]] toolkit::result<> InitTLS() const;
+
         struct State;
         State *m_State{};
     };
+
+    /**
+     * Download the resource at the given location into a file, following redirects. If the server supports byte
+     * ranges, the rest of the file after the first range is fetched over several connections at once, as many as keep
+     * adding to the throughput. Otherwise, it is streamed over one connection.
+     *
+     * @param client
+     * @param location
+     * @param path
+     * @param response status and headers of the first response that was not a redirect
+     * @return
+     */
+    [[nodiscard]] toolkit::result<> Download(
+        const HttpClient &client,
+        URL location,
+        const std::filesystem::path &path,
+        HttpResponse &response);
 }
 
 std::ostream &operator<<(std::ostream &stream, unvm::http::HttpMethod method);
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <unvm/version.hxx>
+
+#include <toolkit/result.hxx>
+
+#include <cstdint>
+#include <filesystem>
+
+namespace unvm
+{
+    /**
+     * Memory-mapped binary copy of the cached index.json. It only contains the entries supported on the current
+     * platform, already packed and sorted like a loaded VersionTable, and records the size and modification time of
+     * the json file it was generated from, so it can be discarded as soon as the json file changes.
+     *
+     * The header is followed by the columns in the order of VersionTable::Columns, Count values each, and the
+     * null-terminated string pool, so a table can reference all of them in place.
+     */
+    class VersionIndex
+    {
+    public:
+        static constexpr uint32_t Revision = 3;
+        static constexpr uint32_t NoString = VersionTable::NoString;
+
+        struct Header
+        {
+            char Magic[4];
+            uint32_t Revision;
+            uint64_t SourceSize;
+            int64_t SourceTime;
+            uint32_t Count;
+            uint32_t PoolSize;
+        };
+
+        /**
+         * Size of one row over all columns.
+         */
+        static constexpr size_t RowSize = sizeof(uint64_t) + 9 * sizeof(uint32_t) + sizeof(uint16_t) + sizeof(uint8_t);
+
+        /**
+         * Size and modification time of the json file an index was generated from.
+         */
+        struct SourceStamp
+        {
+            uint64_t Size;
+            int64_t Time;
+
+            bool operator==(const SourceStamp &) const = default;
+        };
+
+        /**
+         * Get the current stamp of the json file at path.
+         *
+         * @param path
+         * @param stamp
+         * @return
+         */
+        [[nodiscard]] static bool GetSourceStamp(const std::filesystem::path &path, SourceStamp &stamp);
+
+        /**
+         * Map the binary index at path, if it exists and is still up to date with the json file at source_path.
+         *
+         * @param path
+         * @param source_path
+         * @return
+         */
+        [[nodiscard]] static toolkit::result<VersionIndex> Open(
+            const std::filesystem::path &path,
+            const std::filesystem::path &source_path);
+
+        /**
+         * Write the supported entries of the given table to path, in table order, tagged with the stamp of the json
+         * file the table was parsed from. The stamp has to be taken from the copy that was actually read, as the file
+         * may have been replaced since. The file is written to a temporary file first and then renamed, so readers
+         * never observe a partial index.
+         *
+         * @param path
+         * @param source
+         * @param table
+         * @return
+         */
+        [[nodiscard]] static toolkit::result<> Write(
+            const std::filesystem::path &path,
+            const SourceStamp &source,
+            const VersionTable &table);
+
+        VersionIndex() = default;
+        ~VersionIndex();
+
+        VersionIndex(const VersionIndex &) = delete;
+        VersionIndex &operator=(const VersionIndex &) = delete;
+
+        VersionIndex(VersionIndex &&other) noexcept;
+        VersionIndex &operator=(VersionIndex &&other) noexcept;
+
+        [[nodiscard]] size_t Size() const;
+
+        /**
+         * Hand the mapping over to table, which then references the columns and the string pool in place and keeps the
+         * mapping alive. Fails, leaving the table empty, if any string offset points outside of the pool.
+         *
+         * @param table
+         * @return
+         */
+        [[nodiscard]] bool Read(VersionTable &table) &&;
+
+    private:
+        const Header *m_Header{};
+        VersionTable::Columns m_Columns;
+
+        const void *m_Data{};
+        size_t m_Size{};
+
+#if defined(SYSTEM_WINDOWS)
+
+        void *m_Mapping{};
+
+#endif
+    };
+}
@@ -22,7 +22,7 @@ struct data::serializer<unvm::Config>
 };
 
 template<>
-struct data::serializer<unvm::VersionEntry>
+struct data::serializer<unvm::VersionInfo>
 {
-    static bool from_data(const json::Node &node, unvm::VersionEntry &value);
+    static bool from_data(const json::Node &node, unvm::VersionInfo &value);
 };
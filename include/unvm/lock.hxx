@@ -3,6 +3,8 @@
 #include <toolkit/result.hxx>
 
 #include <filesystem>
+#include <string>
+#include <string_view>
 
 namespace unvm
 {
@@ -11,6 +13,14 @@ namespace unvm
     public:
         [[nodiscard]] static toolkit::result<FileLock> Lock(const std::filesystem::path &path);
 
+        /**
+         * Like Lock, but never waits. Results in an empty lock if another process holds it.
+         *
+         * @param path
+         * @return
+         */
+        [[nodiscard]] static toolkit::result<FileLock> TryLock(const std::filesystem::path &path);
+
         FileLock() = default;
         ~FileLock();
 
@@ -20,7 +30,11 @@ namespace unvm
         FileLock(FileLock &&other) noexcept;
         FileLock &operator=(FileLock &&other) noexcept;
 
+        explicit operator bool() const;
+
     private:
+        [[nodiscard]] static toolkit::result<FileLock> Acquire(const std::filesystem::path &path, bool wait);
+
 #if defined(SYSTEM_WINDOWS)
 
         explicit FileLock(void *handle);
@@ -36,6 +50,12 @@ namespace unvm
 #endif
     };
 
+    /**
+     * Marker lock for long running operations on one version, like installing or removing it. The marker file names
+     * the operation and the process id of its holder, and stays locked for as long as the holder is alive. Waiters
+     * block on that lock, so they wake up as soon as it is released, and a marker left behind by a crashed holder is
+     * taken over right away.
+     */
     class TryAcquire
     {
     public:
@@ -57,5 +77,15 @@ namespace unvm
         bool m_Acquired{}, m_Primary{};
         std::filesystem::path m_Path;
         std::string m_Message;
+
+#if defined(SYSTEM_WINDOWS)
+
+        void *m_Handle = nullptr;
+
+#else
+
+        int m_Handle = -1;
+
+#endif
     };
 }
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <unvm/version.hxx>
+
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+
+namespace unvm
+{
+    /**
+     * Lookup index over a view of a loaded version table, for the alias forms FindEffectiveVersion accepts: 'latest', 'lts',
+     * '<major>', '<major>.<minor>', '<major>.<minor>.<patch>', each optionally prefixed with 'v', and LTS codenames in
+     * any case. Every bucket keeps the entry with the highest packed key, so the result does not depend on the order of
+     * the table. Entries that could not be packed are not indexed.
+     *
+     * The index refers to entries by their row in the table and to codenames by string view, so it is only valid as long
+     * as the table of the view it was built from is alive.
+     */
+    class VersionLookup
+    {
+    public:
+        static constexpr uint32_t None = ~uint32_t();
+
+        VersionLookup() = default;
+
+        explicit VersionLookup(const VersionView &view);
+
+        [[nodiscard]] uint32_t Latest() const;
+        [[nodiscard]] uint32_t LatestLTS() const;
+
+        [[nodiscard]] uint32_t Major(uint32_t major) const;
+        [[nodiscard]] uint32_t Minor(uint32_t major, uint32_t minor) const;
+        [[nodiscard]] uint32_t Exact(uint64_t key) const;
+
+        /**
+         * Newest entry of the LTS line with the given codename, compared ignoring ASCII case.
+         *
+         * @param name
+         * @return
+         */
+        [[nodiscard]] uint32_t Codename(std::string_view name) const;
+
+    private:
+        struct FoldHash
+        {
+            size_t operator()(std::string_view value) const;
+        };
+
+        struct FoldEqual
+        {
+            bool operator()(std::string_view a, std::string_view b) const;
+        };
+
+        uint32_t m_Latest = None;
+        uint32_t m_LatestLTS = None;
+
+        std::unordered_map<uint64_t, uint32_t> m_Majors;
+        std::unordered_map<uint64_t, uint32_t> m_Minors;
+        std::unordered_map<uint64_t, uint32_t> m_Exact;
+        std::unordered_map<std::string_view, uint32_t, FoldHash, FoldEqual> m_Codenames;
+    };
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <unvm/util.hxx>
+
+#include <toolkit/result.hxx>
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+namespace unvm
+{
+    constexpr auto VersionFileName = ".unvm";
+    constexpr auto PackageFileName = "package.json";
+
+    /**
+     * Walks from the current directory up to the file system root, one level at a time. Marker files are checked
+     * relative to an open handle of the current level, so the current directory is only resolved once, and full paths
+     * are only built for markers that were actually found. The handles only need search permission on each level. If
+     * a level cannot be opened anyway, the rest of the walk goes by path.
+     */
+    class MarkerScanner
+    {
+    public:
+        [[nodiscard]] static toolkit::result<MarkerScanner> Open();
+
+        MarkerScanner() = default;
+        ~MarkerScanner();
+
+        MarkerScanner(const MarkerScanner &) = delete;
+        MarkerScanner &operator=(const MarkerScanner &) = delete;
+
+        MarkerScanner(MarkerScanner &&other) noexcept;
+        MarkerScanner &operator=(MarkerScanner &&other) noexcept;
+
+        /**
+         * Check if the current level contains a file with the given name, and stamp it if so.
+         *
+         * @param name
+         * @param stamp
+         * @return
+         */
+        [[nodiscard]] bool Find(const char *name, FileStamp *stamp = {}) const;
+
+        /**
+         * Stamp the directory of the current level itself.
+         *
+         * @param stamp
+         * @return
+         */
+        [[nodiscard]] bool Stamp(FileStamp &stamp) const;
+
+        [[nodiscard]] std::filesystem::path Path() const;
+        [[nodiscard]] std::filesystem::path Path(std::string_view name) const;
+
+        /**
+         * Move to the parent directory. Returns false once the root was reached.
+         *
+         * @return
+         */
+        bool Up();
+
+    private:
+#if defined(SYSTEM_WINDOWS)
+
+        std::filesystem::path m_Path;
+
+#else
+
+        std::string m_Path;
+        int m_Handle = -1;
+
+#endif
+    };
+}
@@ -79,6 +79,20 @@ namespace unvm::semver
     using Range = std::variant<Hyphen, PrimitiveSet>;
     using RangeSet = std::vector<Range>;
 
+    /**
+     * Half-open interval [Begin, End) over packed version keys.
+     */
+    struct Interval
+    {
+        uint64_t Begin{};
+        uint64_t End{};
+    };
+
+    /**
+     * Sorted, disjoint intervals, which match exactly the release versions a range set matches.
+     */
+    using IntervalSet = std::vector<Interval>;
+
     class Parser final
     {
     public:
@@ -130,10 +144,61 @@ namespace unvm::semver
     [[nodiscard]] toolkit::result<RangeSet> ParseRangeSet(std::string_view str);
     [[nodiscard]] toolkit::result<RangeSet> ParseRangeSet(const std::string &str);
 
+    /**
+     * Parse a plain release version like 'v20.11.1' or '20.11.1', as used by index.json, without allocating. Anything
+     * with pre-release or build parts is rejected and needs the full Parser.
+     *
+     * @param str
+     * @param version
+     * @return
+     */
+    [[nodiscard]] bool ParseReleaseVersion(std::string_view str, Version &version);
+
     [[nodiscard]] toolkit::result<bool> IsInRange(const RangeSet &set, std::string_view version);
     [[nodiscard]] toolkit::result<bool> IsInRange(const RangeSet &set, const std::string &version);
     [[nodiscard]] toolkit::result<bool> IsInRange(const RangeSet &set, const Version &version);
 
+    /**
+     * Pack a release version into a key that orders like the version itself. Every part must be below 2^21. A valid
+     * key is never zero, so zero can mark versions that could not be packed.
+     *
+     * @param major
+     * @param minor
+     * @param patch
+     * @param key
+     * @return
+     */
+    [[nodiscard]] bool PackVersion(uint32_t major, uint32_t minor, uint32_t patch, uint64_t &key);
+    /**
+     * Pack a plain release version like 'v20.11.1' or '20.11.1'. Versions with pre-release or build parts are not
+     * packed.
+     *
+     * @param version
+     * @param key
+     * @return
+     */
+    [[nodiscard]] bool PackVersion(std::string_view version, uint64_t &key);
+    /**
+     * Restore the release version of a valid packed key.
+     *
+     * @param key
+     * @return
+     */
+    [[nodiscard]] Version UnpackVersion(uint64_t key);
+
+    /**
+     * Compile a range set into intervals over packed keys. Fails for ranges that cannot be expressed like that, namely
+     * bounds with pre-release parts and wildcards in the middle of an exact match, so callers can fall back to
+     * IsInRange on the range set.
+     *
+     * @param set
+     * @param intervals
+     * @return
+     */
+    [[nodiscard]] bool CompileRangeSet(const RangeSet &set, IntervalSet &intervals);
+
+    [[nodiscard]] bool IsInRange(const IntervalSet &intervals, uint64_t key);
+
     bool operator==(const Partial &a, const Partial &b);
     bool operator<(const Partial &a, const Partial &b);
     bool operator<=(const Partial &a, const Partial &b);
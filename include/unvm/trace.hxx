@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+
+namespace unvm
+{
+    /**
+     * Set once at startup if the UNVM_TRACE environment variable names an output directory. Everything else about
+     * tracing is skipped behind this flag.
+     */
+    extern const bool TraceEnabled;
+
+    /**
+     * Record the time between construction and destruction as one complete event. The name must outlive the
+     * process, so pass string literals only.
+     */
+    class TraceSpan
+    {
+    public:
+        explicit TraceSpan(const char *name)
+        {
+            if (TraceEnabled)
+            {
+                Begin(name);
+            }
+        }
+
+        ~TraceSpan()
+        {
+            if (m_Name)
+            {
+                End();
+            }
+        }
+
+        TraceSpan(const TraceSpan &) = delete;
+        TraceSpan &operator=(const TraceSpan &) = delete;
+
+    private:
+        void Begin(const char *name);
+        void End();
+
+        const char *m_Name{};
+    };
+
+    /**
+     * Write all spans recorded so far as Chrome trace-event JSON to 'unvm-<pid>-<start>.json' in the trace directory,
+     * replacing what an earlier call wrote. Spans that are still open are written as ending now, and go on from here
+     * if the process does. This runs at exit, and must be called right before replacing the process.
+     */
+    void FlushTrace();
+}
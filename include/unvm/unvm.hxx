@@ -1,6 +1,9 @@
 #pragma once
 
+#include <unvm/cache.hxx>
 #include <unvm/config.hxx>
+#include <unvm/context.hxx>
+#include <unvm/lookup.hxx>
 #include <unvm/version.hxx>
 #include <unvm/http/http.hxx>
 
@@ -8,10 +11,20 @@
 #include <toolkit/result.hxx>
 
 #include <filesystem>
+#include <optional>
+#include <string>
 #include <string_view>
 
 namespace unvm
 {
+    constexpr auto DaemonSocketName = "daemon.sock";
+
+    /**
+     * Flags understood by unvm and its shims. Shared with the standalone shim, which has to parse its arguments the
+     * same way before handing them to Shim.
+     */
+    extern const toolkit::arg_manifest Manifest;
+
     void PrintManual();
 
     [[nodiscard]] toolkit::result<> LoadVersionTable(
@@ -19,14 +32,22 @@ namespace unvm
         VersionTable &table,
         bool online);
 
-    void FilterVersionTable(const Config &config, VersionTable &table, bool supported = false, bool installed = false);
+    [[nodiscard]] VersionView FilterVersionTable(
+        const Config &config,
+        const VersionView &view,
+        bool supported = false,
+        bool installed = false);
 
-    const VersionEntry *FindEffectiveVersion(
-        const VersionTable &table,
+    VersionEntry FindEffectiveVersion(
+        const VersionView &view,
+        const VersionLookup &lookup,
         std::string_view version,
         bool &matched);
 
-    toolkit::result<const VersionEntry *> FindVersionEntry(const VersionTable &table, std::string_view version);
+    toolkit::result<VersionEntry> FindVersionEntry(
+        const VersionView &view,
+        const VersionLookup &lookup,
+        std::string_view version);
 
     [[nodiscard]] toolkit::result<> UnpackArchive(
         std::istream &stream,
@@ -34,40 +55,103 @@ namespace unvm
 
     [[nodiscard]] toolkit::result<> Install(
         Config &config,
-        http::HttpClient &client,
+        ResolutionContext &resolution,
         std::string_view version,
         const VersionEntry &entry);
     [[nodiscard]] toolkit::result<> Install(
         Config &config,
-        http::HttpClient &client,
+        ResolutionContext &resolution,
         std::string_view version);
 
     [[nodiscard]] toolkit::result<> Remove(
         Config &config,
-        http::HttpClient &client,
+        ResolutionContext &resolution,
         std::string_view version);
 
     [[nodiscard]] toolkit::result<> Use(
         Config &config,
-        http::HttpClient &client,
+        ResolutionContext &resolution,
         std::string_view version,
         bool local);
 
     [[nodiscard]] toolkit::result<> List(
         const Config &config,
-        http::HttpClient &client,
+        ResolutionContext &resolution,
         bool available,
         bool flat,
         bool details);
 
     [[nodiscard]] toolkit::result<> Complete(
         const Config &config,
-        http::HttpClient &client,
+        ResolutionContext &resolution,
         const toolkit::arg_context &args);
 
+    /**
+     * Check if the given version is installed, without consulting the version table.
+     *
+     * @param config
+     * @param version
+     * @return
+     */
+    [[nodiscard]] bool IsInstalled(const Config &config, const std::string &version);
+
+    /**
+     * Detect the active version for the current directory and resolve it against the installed versions. An installed
+     * exact version is taken as is, anything else goes through the version table. Sets Detected and Active of the
+     * config, and records the outcome, whether a shim may run it directly, and everything it depends on in resolved.
+     *
+     * @param config
+     * @param resolution
+     * @param resolved
+     * @return
+     */
+    [[nodiscard]] toolkit::result<> ResolveActiveVersion(
+        Config &config,
+        ResolutionContext &resolution,
+        ResolutionEntry &resolved);
+
+    /**
+     * Serve resolutions to shims over a unix socket in the data directory until interrupted. The config, the version
+     * table and all resolutions are kept in memory, and dropped as soon as inotify reports a change to the config, the
+     * version table or any of the directories they were resolved from.
+     *
+     * @param config
+     * @param client
+     * @return
+     */
+    [[nodiscard]] toolkit::result<> Daemon(Config &config, http::HttpClient &client);
+
+    /**
+     * Ask a running daemon for the installed version active in the given directory. Results in null if no daemon is
+     * running, it does not answer in time, or the version is not resolved and installed yet, in which case the caller
+     * has to resolve it on its own.
+     *
+     * @param directory
+     * @return
+     */
+    [[nodiscard]] std::optional<std::string> QueryDaemon(const std::filesystem::path &directory);
+
+    /**
+     * Path of the node executable of an installed version.
+     *
+     * @param version
+     * @return
+     */
+    std::filesystem::path GetNodeExecutable(std::string_view version);
+
+    /**
+     * Replace the current process with the node, npm or npx executable of the given installed version, depending on
+     * the name the shim was invoked with. Only returns on failure.
+     *
+     * @param version
+     * @param context
+     * @return
+     */
+    [[nodiscard]] toolkit::result<> Shim(std::string_view version, const toolkit::arg_context &context);
+
     [[nodiscard]] toolkit::result<> Execute(
         Config &config,
-        http::HttpClient &client,
+        ResolutionContext &resolution,
         std::string_view version,
         bool yes,
         const toolkit::arg_context &context);
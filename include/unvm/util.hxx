@@ -4,8 +4,10 @@
 #include <toolkit/string.hxx>
 
 #include <charconv>
+#include <cstdint>
 #include <filesystem>
 #include <format>
+#include <initializer_list>
 #include <iostream>
 #include <map>
 #include <optional>
@@ -32,20 +34,86 @@ namespace unvm
         Exact,
     };
 
+    /**
+     * Identity of a file or directory at some point in time. Two stamps of the same path differ if the file was
+     * modified, replaced or, for directories, if an entry was added, removed or renamed.
+     */
+    struct FileStamp
+    {
+        int64_t Time{};
+        uint64_t Inode{};
+        uint64_t Size{};
+
+        bool operator==(const FileStamp &) const = default;
+    };
+
+    struct FileDependency
+    {
+        std::filesystem::path Path;
+        FileStamp Stamp;
+    };
+
+    using FileDependencies = std::vector<FileDependency>;
+
+    [[nodiscard]] bool GetFileStamp(const std::filesystem::path &path, FileStamp &stamp);
+
+#if !defined(SYSTEM_WINDOWS)
+
+    /**
+     * Stamp a file relative to an open directory descriptor, without resolving its full path.
+     *
+     * @param directory
+     * @param name
+     * @param stamp
+     * @return
+     */
+    [[nodiscard]] bool GetFileStamp(int directory, const char *name, FileStamp &stamp);
+
+#endif
+
     std::filesystem::path GetDataDirectory();
 
+    /**
+     * Replace to with from in one step, like std::filesystem::rename. On Windows, where the rename fails while a
+     * reader has the target open, it is retried for a short while before giving up.
+     *
+     * @param from
+     * @param to
+     * @param ec
+     */
+    void RenameFile(const std::filesystem::path &from, const std::filesystem::path &to, std::error_code &ec);
+
     std::istream &GetLine(std::istream &stream, std::string &string, std::string_view delim);
 
+    /**
+     * Find the string at the given key path in a json document, without building a DOM. Results are the same as
+     * with a DOM: the last of several equal keys wins, null if the path does not exist or the value is null, and an
+     * error if the document or a value on the path is not an object, or the value is not a string. Every object on the
+     * path is read to its end for that, but all values off the path are skipped without being materialized, and
+     * nothing after the top-level object is read.
+     *
+     * @param buffer
+     * @param path
+     * @return
+     */
+    [[nodiscard]] toolkit::result<std::optional<std::string>> FindJsonString(
+        std::streambuf &buffer,
+        std::initializer_list<std::string_view> path);
+
     /**
      * Detect the active version for the current context. Detect versions from package.json, .unvm and global configs.
+     * If dependencies is set, it receives every directory visited and every marker file read, so the result can be
+     * cached until one of them changes.
      *
      * @param def
      * @param type
+     * @param dependencies
      * @return
      */
     [[nodiscard]] toolkit::result<std::optional<std::string>> FindActiveVersion(
         const std::optional<std::string> &def,
-        VersionType *type = {});
+        VersionType *type = {},
+        FileDependencies *dependencies = {});
 
     bool FindVersionFile(std::filesystem::path &path);
 
@@ -2,14 +2,69 @@
 
 #include <cstdint>
 #include <format>
+#include <memory>
 #include <optional>
 #include <set>
+#include <span>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 namespace unvm
 {
-    struct VersionEntry
+    /**
+     * Download tokens used by the files array of index.json. A set of them is stored as a bitmask over this list,
+     * unknown tokens are dropped.
+     */
+    constexpr std::string_view PlatformFiles[]
+    {
+        "aix-ppc64",
+        "headers",
+        "linux-arm64",
+        "linux-armv6l",
+        "linux-armv7l",
+        "linux-ppc64le",
+        "linux-s390x",
+        "linux-x64",
+        "linux-x86",
+        "osx-arm64-pkg",
+        "osx-arm64-tar",
+        "osx-x64-pkg",
+        "osx-x64-tar",
+        "osx-x86-tar",
+        "src",
+        "sunos-x64",
+        "sunos-x86",
+        "win-arm64-7z",
+        "win-arm64-zip",
+        "win-x64-7z",
+        "win-x64-exe",
+        "win-x64-msi",
+        "win-x64-zip",
+        "win-x86-7z",
+        "win-x86-exe",
+        "win-x86-msi",
+        "win-x86-zip",
+    };
+
+    constexpr uint32_t GetPlatformFileMask(const std::string_view file)
+    {
+        for (size_t i = 0; i < std::size(PlatformFiles); ++i)
+        {
+            if (PlatformFiles[i] == file)
+            {
+                return 1u << i;
+            }
+        }
+
+        return 0;
+    }
+
+    /**
+     * One element of index.json as parsed from json. Only used to build a VersionTable.
+     */
+    struct VersionInfo
     {
         std::string Version;
         std::string Date;
@@ -19,12 +74,310 @@ namespace unvm
         std::optional<std::string> UV;
         std::optional<std::string> ZLib;
         std::optional<std::string> OpenSSL;
-        uint16_t Modules;
+        uint16_t Modules{};
         std::optional<std::string> LTS;
         bool Security{};
     };
 
-    using VersionTable = std::vector<VersionEntry>;
+    class VersionTable;
+
+    /**
+     * Handle of one row of a version table. A default constructed entry refers to no row and converts to false. Valid
+     * as long as the table it refers to is neither modified nor destroyed.
+     */
+    class VersionEntry
+    {
+    public:
+        VersionEntry() = default;
+        VersionEntry(const VersionTable *table, uint32_t index);
+
+        explicit operator bool() const;
+
+        bool operator==(const VersionEntry &) const = default;
+
+        [[nodiscard]] const VersionTable &Table() const;
+        [[nodiscard]] uint32_t Index() const;
+
+        [[nodiscard]] uint64_t Key() const;
+        [[nodiscard]] std::string_view Version() const;
+        [[nodiscard]] uint32_t Date() const;
+        [[nodiscard]] uint32_t Files() const;
+        [[nodiscard]] std::optional<std::string_view> NPM() const;
+        [[nodiscard]] std::string_view V8() const;
+        [[nodiscard]] std::optional<std::string_view> UV() const;
+        [[nodiscard]] std::optional<std::string_view> ZLib() const;
+        [[nodiscard]] std::optional<std::string_view> OpenSSL() const;
+        [[nodiscard]] uint16_t Modules() const;
+        [[nodiscard]] std::optional<std::string_view> LTS() const;
+        [[nodiscard]] bool Security() const;
+
+    private:
+        const VersionTable *m_Table{};
+        uint32_t m_Index{};
+    };
+
+    /**
+     * Column-wise version table. Versions are stored as packed keys next to their string, dates as yyyymmdd integers,
+     * files as a bitmask over PlatformFiles, and all other strings as offsets into one pool of null-terminated,
+     * deduplicated strings.
+     *
+     * The columns either belong to the table, or, after Attach, live in memory owned by someone else, like a mapped
+     * binary index. Such a table copies them on the first modification.
+     */
+    class VersionTable
+    {
+    public:
+        static constexpr uint32_t NoString = ~uint32_t();
+
+        /**
+         * Raw values of one row, strings as offsets into the pool.
+         */
+        struct Row
+        {
+            uint64_t Key{};
+            uint32_t Version = NoString;
+            uint32_t Date{};
+            uint32_t Files{};
+            uint32_t NPM = NoString;
+            uint32_t V8 = NoString;
+            uint32_t UV = NoString;
+            uint32_t ZLib = NoString;
+            uint32_t OpenSSL = NoString;
+            uint32_t LTS = NoString;
+            uint16_t Modules{};
+            bool Security{};
+        };
+
+        /**
+         * All columns of a table, of equal size, and the pool their string offsets point into.
+         */
+        struct Columns
+        {
+            std::span<const uint64_t> Key;
+            std::span<const uint32_t> Version;
+            std::span<const uint32_t> Date;
+            std::span<const uint32_t> Files;
+            std::span<const uint32_t> NPM;
+            std::span<const uint32_t> V8;
+            std::span<const uint32_t> UV;
+            std::span<const uint32_t> ZLib;
+            std::span<const uint32_t> OpenSSL;
+            std::span<const uint32_t> LTS;
+            std::span<const uint16_t> Modules;
+            std::span<const uint8_t> Security;
+            std::string_view Pool;
+        };
+
+        class Iterator
+        {
+        public:
+            using value_type = VersionEntry;
+            using difference_type = std::ptrdiff_t;
+
+            Iterator() = default;
+            Iterator(const VersionTable *table, uint32_t index);
+
+            VersionEntry operator*() const;
+            Iterator &operator++();
+            Iterator operator++(int);
+
+            bool operator==(const Iterator &) const = default;
+
+        private:
+            const VersionTable *m_Table{};
+            uint32_t m_Index{};
+        };
+
+        VersionTable() = default;
+
+        // entries point at the table, so it stays where it was created
+        VersionTable(const VersionTable &) = delete;
+        VersionTable &operator=(const VersionTable &) = delete;
+
+        [[nodiscard]] size_t Size() const;
+        [[nodiscard]] bool Empty() const;
+
+        [[nodiscard]] VersionEntry operator[](size_t index) const;
+
+        [[nodiscard]] Iterator begin() const;
+        [[nodiscard]] Iterator end() const;
+
+        [[nodiscard]] std::span<const uint64_t> Keys() const;
+        [[nodiscard]] std::string_view Pool() const;
+        [[nodiscard]] Row Raw(size_t index) const;
+
+        [[nodiscard]] uint64_t Key(size_t index) const;
+        [[nodiscard]] std::string_view Version(size_t index) const;
+        [[nodiscard]] uint32_t Date(size_t index) const;
+        [[nodiscard]] uint32_t Files(size_t index) const;
+        [[nodiscard]] std::optional<std::string_view> NPM(size_t index) const;
+        [[nodiscard]] std::string_view V8(size_t index) const;
+        [[nodiscard]] std::optional<std::string_view> UV(size_t index) const;
+        [[nodiscard]] std::optional<std::string_view> ZLib(size_t index) const;
+        [[nodiscard]] std::optional<std::string_view> OpenSSL(size_t index) const;
+        [[nodiscard]] uint16_t Modules(size_t index) const;
+        [[nodiscard]] std::optional<std::string_view> LTS(size_t index) const;
+        [[nodiscard]] bool Security(size_t index) const;
+
+        void Clear();
+        void Reserve(size_t count);
+
+        /**
+         * Replace the contents with columns stored elsewhere, without copying them. The columns must be of equal size,
+         * the pool must end with a null character, and all string offsets must point into it. backing keeps the
+         * memory alive for as long as the table references it.
+         *
+         * @param columns
+         * @param backing
+         */
+        void Attach(const Columns &columns, std::shared_ptr<const void> backing);
+
+        /**
+         * Append a parsed row, packing its version and date, and interning its strings.
+         *
+         * @param info
+         */
+        void Append(const VersionInfo &info);
+        /**
+         * Append a raw row, whose string offsets point into the current pool.
+         *
+         * @param row
+         */
+        void Append(const Row &row);
+
+        /**
+         * Sort newest first by packed key, with rows that could not be packed last, keeping their relative order.
+         */
+        void Sort();
+
+    private:
+        [[nodiscard]] std::string_view String(uint32_t offset) const;
+        [[nodiscard]] std::optional<std::string_view> OptionalString(uint32_t offset) const;
+
+        uint32_t Intern(std::string_view value);
+        uint32_t InternOptional(const std::optional<std::string> &value);
+
+        void Reorder(const std::vector<uint32_t> &order);
+
+        /**
+         * Copy attached columns into the table, before modifying it.
+         */
+        void Own();
+        /**
+         * Point the columns at the vectors of the table, after modifying them.
+         */
+        void Sync();
+
+        Columns m_Columns;
+        std::shared_ptr<const void> m_Backing;
+
+        std::vector<uint64_t> m_Key;
+        std::vector<uint32_t> m_Version;
+        std::vector<uint32_t> m_Date;
+        std::vector<uint32_t> m_Files;
+        std::vector<uint32_t> m_NPM;
+        std::vector<uint32_t> m_V8;
+        std::vector<uint32_t> m_UV;
+        std::vector<uint32_t> m_ZLib;
+        std::vector<uint32_t> m_OpenSSL;
+        std::vector<uint16_t> m_Modules;
+        std::vector<uint32_t> m_LTS;
+        std::vector<uint8_t> m_Security;
+
+        std::string m_Pool;
+        std::unordered_multimap<size_t, uint32_t> m_Interned;
+    };
+
+    /**
+     * Immutable subset of the rows of a shared version table, in table order. Views share the table instead of copying
+     * it, so any number of differently filtered views can be taken from one loaded table. Entries of a view stay valid
+     * as long as any view of the table is alive.
+     */
+    class VersionView
+    {
+    public:
+        class Iterator
+        {
+        public:
+            using value_type = VersionEntry;
+            using difference_type = std::ptrdiff_t;
+
+            Iterator() = default;
+            Iterator(const VersionView *view, size_t position);
+
+            VersionEntry operator*() const;
+            Iterator &operator++();
+            Iterator operator++(int);
+
+            bool operator==(const Iterator &) const = default;
+
+        private:
+            const VersionView *m_View{};
+            size_t m_Position{};
+        };
+
+        VersionView() = default;
+
+        /**
+         * View of all rows of the table.
+         *
+         * @param table
+         */
+        explicit VersionView(std::shared_ptr<const VersionTable> table);
+
+        VersionView(std::shared_ptr<const VersionTable> table, std::vector<uint32_t> rows);
+
+        [[nodiscard]] const VersionTable &Table() const;
+        [[nodiscard]] std::span<const uint32_t> Rows() const;
+
+        [[nodiscard]] size_t Size() const;
+        [[nodiscard]] bool Empty() const;
+
+        /**
+         * Entry at the given position of the view.
+         *
+         * @param position
+         * @return
+         */
+        [[nodiscard]] VersionEntry operator[](size_t position) const;
+        /**
+         * Entry of the given row of the underlying table.
+         *
+         * @param row
+         * @return
+         */
+        [[nodiscard]] VersionEntry Entry(uint32_t row) const;
+
+        [[nodiscard]] Iterator begin() const;
+        [[nodiscard]] Iterator end() const;
+
+        /**
+         * Sub-view of the rows for which keep returns true.
+         *
+         * @param keep
+         * @return
+         */
+        template<typename P>
+        [[nodiscard]] VersionView Filter(P &&keep) const
+        {
+            std::vector<uint32_t> rows;
+            rows.reserve(m_Rows.size());
+
+            for (const auto row : m_Rows)
+            {
+                if (keep(Entry(row)))
+                {
+                    rows.push_back(row);
+                }
+            }
+
+            return { m_Table, std::move(rows) };
+        }
+
+    private:
+        std::shared_ptr<const VersionTable> m_Table;
+        std::vector<uint32_t> m_Rows;
+    };
 
     struct Platform
     {
@@ -0,0 +1,120 @@
+/**
+ * Standalone shim for node, npm and npx.
+ *
+ * Only handles the launches that need no config, version table, network or prompts: a resolution handed down by a
+ * parent shim, an answer from a running daemon, or a valid entry of the resolution cache. Everything else is passed
+ * on to the full unvm binary next to this executable, with the arguments unchanged, so it can resolve, install or
+ * report errors as usual. Links neither OpenSSL, libarchive nor the json library, so a launch does not pay for
+ * loading them.
+ */
+
+#include <unvm/cache.hxx>
+#include <unvm/trace.hxx>
+#include <unvm/unvm.hxx>
+#include <unvm/util.hxx>
+
+#include <toolkit/args.hxx>
+
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#include <unistd.h>
+
+#if defined(SYSTEM_DARWIN)
+
+#include <mach-o/dyld.h>
+
+#endif
+
+static std::filesystem::path get_self_path()
+{
+#if defined(SYSTEM_DARWIN)
+
+    char buffer[4096];
+    uint32_t size = sizeof(buffer);
+    if (_NSGetExecutablePath(buffer, &size))
+    {
+        return {};
+    }
+
+    std::error_code ec;
+    return std::filesystem::canonical(buffer, ec);
+
+#else
+
+    std::error_code ec;
+    return std::filesystem::canonical("/proc/self/exe", ec);
+
+#endif
+}
+
+/**
+ * Find the installed version active in the given directory without reading the config.
+ */
+static std::optional<std::string> find_version(const std::filesystem::path &directory)
+{
+    if (unvm::ResolutionEntry inherited; unvm::ImportResolution(directory, inherited) && inherited.Direct)
+    {
+        return std::move(inherited.Resolved);
+    }
+
+    if (auto version = unvm::QueryDaemon(directory))
+    {
+        return version;
+    }
+
+    // resolve.cache is discarded with every change to the config, so a version resolved from it is still installed,
+    // unless someone removed its files by hand
+    const auto cache = unvm::ResolutionCache::Open();
+
+    unvm::ResolutionEntry cached;
+    if (!cache.Find(directory, cached) || !cached.Direct || !cached.Resolved)
+    {
+        return std::nullopt;
+    }
+
+    std::error_code ec;
+    if (!std::filesystem::exists(unvm::GetNodeExecutable(*cached.Resolved), ec))
+    {
+        return std::nullopt;
+    }
+
+    unvm::ExportResolution(directory, cached);
+    return std::move(cached.Resolved);
+}
+
+int main(const int argc, char **argv)
+{
+    std::error_code ec;
+    const auto directory = std::filesystem::current_path(ec);
+
+    if (!ec)
+    {
+        if (auto version = find_version(directory))
+        {
+            toolkit::arg_context context;
+            if (auto res = toolkit::arg_parse(unvm::Manifest, argc, argv) >> context; !res)
+            {
+                std::cerr << res.error() << std::endl;
+                return 1;
+            }
+
+            if (auto res = unvm::Shim(*version, context); !res)
+            {
+                std::cerr << res.error() << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    // argv[0] still names the shim, so the full binary takes the shim path as well
+    const auto unvm_path = (get_self_path().parent_path() / "unvm").string();
+
+    unvm::FlushTrace();
+
+    execv(unvm_path.c_str(), argv);
+
+    std::cerr << "failed to execute '" << unvm_path << "': " << std::strerror(errno) << std::endl;
+    return 1;
+}
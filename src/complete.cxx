@@ -3,7 +3,10 @@
 #include <iostream>
 #include <ranges>
 
-toolkit::result<> unvm::Complete(const Config &config, http::HttpClient &client, const toolkit::arg_context &args)
+toolkit::result<> unvm::Complete(
+    const Config &config,
+    ResolutionContext &resolution,
+    const toolkit::arg_context &args)
 {
     if (args.limit != ~size_t())
     {
@@ -21,7 +24,7 @@ toolkit::result<> unvm::Complete(const Config &config, http::HttpClient &client,
     // root
     if (args.empty())
     {
-        std::cout << "i install r remove u use l list c complete x e exec execute";
+        std::cout << "i install r remove u use l list c complete x e exec execute d daemon";
         return {};
     }
 
@@ -31,7 +34,7 @@ toolkit::result<> unvm::Complete(const Config &config, http::HttpClient &client,
         if (args.size() == 1)
         {
             std::cout << "latest lts ";
-            if (auto res = List(config, client, true, true, false); !res)
+            if (auto res = List(config, resolution, true, true, false); !res)
             {
                 return res;
             }
@@ -47,7 +50,7 @@ toolkit::result<> unvm::Complete(const Config &config, http::HttpClient &client,
         {
             std::cout << "latest lts ";
 
-            if (auto res = List(config, client, false, true, false); !res)
+            if (auto res = List(config, resolution, false, true, false); !res)
             {
                 return res;
             }
@@ -68,7 +71,7 @@ toolkit::result<> unvm::Complete(const Config &config, http::HttpClient &client,
         {
             std::cout << "none latest lts ";
 
-            if (auto res = List(config, client, false, true, false); !res)
+            if (auto res = List(config, resolution, false, true, false); !res)
             {
                 return res;
             }
@@ -116,7 +119,7 @@ toolkit::result<> unvm::Complete(const Config &config, http::HttpClient &client,
         {
             std::cout << "latest lts ";
 
-            if (auto res = List(config, client, false, true, false); !res)
+            if (auto res = List(config, resolution, false, true, false); !res)
             {
                 return res;
             }
@@ -1,6 +1,7 @@
 #include <unvm/config.hxx>
 #include <unvm/json.hxx>
 #include <unvm/lock.hxx>
+#include <unvm/trace.hxx>
 #include <unvm/util.hxx>
 
 #include <fstream>
@@ -33,33 +34,21 @@ void unvm::MergeConfig(Config &dst, const Config &src)
     }
 }
 
-toolkit::result<> unvm::ReadConfigFile(Config &config)
+/**
+ * Read a snapshot of the config file. The file is only ever replaced by rename, so this needs no lock: an open stream
+ * always refers to one complete version of the file, even if it is replaced while reading.
+ */
+[[nodiscard]] static toolkit::result<> read_config_file(const std::filesystem::path &path, unvm::Config &config)
 {
-    auto data_directory = GetDataDirectory();
-
-    if (std::error_code ec; std::filesystem::create_directories(data_directory, ec), ec)
-    {
-        return toolkit::make_error("failed to create data directory: {} ({}).", ec.message(), ec.value());
-    }
-
-    auto path = data_directory / "config.json";
-    auto lock_path = data_directory / "config.lock";
-
-    FileLock lock;
-    if (auto res = FileLock::Lock(lock_path) >> lock; !res)
-    {
-        return res;
-    }
-
-    if (!std::filesystem::exists(path))
-    {
-        config = {};
-        return {};
-    }
-
     std::ifstream stream(path);
     if (!stream)
     {
+        if (std::error_code ec; !std::filesystem::exists(path, ec) && !ec)
+        {
+            config = {};
+            return {};
+        }
+
         return toolkit::make_error("failed to open config file.");
     }
 
@@ -74,8 +63,24 @@ toolkit::result<> unvm::ReadConfigFile(Config &config)
     return {};
 }
 
+toolkit::result<> unvm::ReadConfigFile(Config &config)
+{
+    TraceSpan span("ReadConfigFile");
+
+    auto data_directory = GetDataDirectory();
+
+    if (std::error_code ec; std::filesystem::create_directories(data_directory, ec), ec)
+    {
+        return toolkit::make_error("failed to create data directory: {} ({}).", ec.message(), ec.value());
+    }
+
+    return read_config_file(data_directory / "config.json", config);
+}
+
 toolkit::result<> unvm::WriteConfigFile(Config &config)
 {
+    TraceSpan span("WriteConfigFile");
+
     if (!config.UpdatedDefault
         && config.AddedVersions.empty()
         && config.RemovedVersions.empty()
@@ -96,6 +101,7 @@ toolkit::result<> unvm::WriteConfigFile(Config &config)
     auto temp_path = data_directory / "config.temp";
     auto lock_path = data_directory / "config.lock";
 
+    // writers still serialize, so no change made by a concurrent writer gets lost during the merge
     FileLock lock;
     if (auto res = FileLock::Lock(lock_path) >> lock; !res)
     {
@@ -103,21 +109,9 @@ toolkit::result<> unvm::WriteConfigFile(Config &config)
     }
 
     Config merged;
-    if (std::filesystem::exists(path))
+    if (auto res = read_config_file(path, merged); !res)
     {
-        std::ifstream stream(path);
-        if (!stream)
-        {
-            return toolkit::make_error("failed to open config file.");
-        }
-
-        json::Node json;
-        stream >> json;
-
-        if (!(json >> merged))
-        {
-            return toolkit::make_error("failed to parse config file.");
-        }
+        return res;
     }
 
     MergeConfig(merged, config);
@@ -131,14 +125,15 @@ toolkit::result<> unvm::WriteConfigFile(Config &config)
 
         stream << json::Node(merged);
         stream.close();
-    }
 
-    if (std::error_code ec; std::filesystem::remove(path), ec)
-    {
-        return toolkit::make_error("failed to remove config file: {} ({}).", ec.message(), ec.value());
+        if (!stream)
+        {
+            return toolkit::make_error("failed to write config file.");
+        }
     }
 
-    if (std::error_code ec; std::filesystem::rename(temp_path, path), ec)
+    // replace the file in one step, readers without the lock must never observe a missing or partial config
+    if (std::error_code ec; RenameFile(temp_path, path, ec), ec)
     {
         return toolkit::make_error("failed to rename config file: {} ({}).", ec.message(), ec.value());
     }
@@ -153,6 +148,8 @@ toolkit::result<> unvm::WriteConfigFile(Config &config)
 
 toolkit::result<> unvm::ReloadConfigFile(Config &config)
 {
+    TraceSpan span("ReloadConfigFile");
+
     auto data_directory = GetDataDirectory();
 
     if (std::error_code ec; std::filesystem::create_directories(data_directory, ec), ec)
@@ -160,31 +157,10 @@ toolkit::result<> unvm::ReloadConfigFile(Config &config)
         return toolkit::make_error("failed to create data directory: {} ({}).", ec.message(), ec.value());
     }
 
-    auto path = data_directory / "config.json";
-    auto lock_path = data_directory / "config.lock";
-
-    FileLock lock;
-    if (auto res = FileLock::Lock(lock_path) >> lock; !res)
-    {
-        return res;
-    }
-
     Config merged;
-    if (std::filesystem::exists(path))
+    if (auto res = read_config_file(data_directory / "config.json", merged); !res)
     {
-        std::ifstream stream(path);
-        if (!stream)
-        {
-            return toolkit::make_error("failed to open config file.");
-        }
-
-        json::Node json;
-        stream >> json;
-
-        if (!(json >> merged))
-        {
-            return toolkit::make_error("failed to parse config file.");
-        }
+        return res;
     }
 
     MergeConfig(merged, config);
@@ -0,0 +1,475 @@
+#include <unvm/cache.hxx>
+#include <unvm/config.hxx>
+#include <unvm/context.hxx>
+#include <unvm/scanner.hxx>
+#include <unvm/trace.hxx>
+#include <unvm/unvm.hxx>
+#include <unvm/util.hxx>
+
+#include <toolkit/defer.hxx>
+
+#include <iostream>
+
+#if defined(SYSTEM_LINUX) || defined(SYSTEM_ANDROID)
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+/**
+ * Events on a watched directory that may change the resolution of anything below it. Changes to files inside it are
+ * reported with the file name, so the marker files need no watches of their own.
+ */
+static constexpr uint32_t watch_mask = IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM
+                                       | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+static volatile std::sig_atomic_t stop_requested{};
+
+static void request_stop(int)
+{
+    stop_requested = 1;
+}
+
+/**
+ * Resolutions of the daemon, each stored with the inotify watches of the directories it was resolved from. Watches
+ * are never removed one by one, but all at once when the cache is reset.
+ */
+class DaemonCache
+{
+public:
+    DaemonCache() = default;
+
+    ~DaemonCache()
+    {
+        Close();
+    }
+
+    DaemonCache(const DaemonCache &) = delete;
+    DaemonCache &operator=(const DaemonCache &) = delete;
+
+    [[nodiscard]] toolkit::result<> Reset()
+    {
+        Close();
+
+        m_Handle = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (m_Handle < 0)
+        {
+            return toolkit::make_error("failed to initialize inotify: {}", std::strerror(errno));
+        }
+
+        m_DataWatch = inotify_add_watch(m_Handle, unvm::GetDataDirectory().c_str(), watch_mask);
+        if (m_DataWatch < 0)
+        {
+            return toolkit::make_error("failed to watch data directory: {}", std::strerror(errno));
+        }
+
+        return {};
+    }
+
+    [[nodiscard]] int Handle() const
+    {
+        return m_Handle;
+    }
+
+    [[nodiscard]] const std::optional<std::string> *Find(const std::string &directory) const
+    {
+        const auto it = m_Entries.find(directory);
+        return it != m_Entries.end() ? &it->second : nullptr;
+    }
+
+    /**
+     * Store a resolution, if all directories it depends on could be watched. Otherwise it would never be invalidated,
+     * so it is not stored at all.
+     */
+    [[nodiscard]] toolkit::result<> Insert(const std::string &directory, const unvm::ResolutionEntry &entry)
+    {
+        if (m_Entries.size() >= unvm::ResolutionCache::Capacity)
+        {
+            if (auto res = Reset(); !res)
+            {
+                return res;
+            }
+        }
+
+        std::vector<int> watches;
+
+        for (auto &dependency : entry.Dependencies)
+        {
+            if (auto name = dependency.Path.filename();
+                name == unvm::VersionFileName || name == unvm::PackageFileName)
+            {
+                continue;
+            }
+
+            const auto watch = inotify_add_watch(m_Handle, dependency.Path.c_str(), watch_mask);
+            if (watch < 0)
+            {
+                return {};
+            }
+
+            watches.push_back(watch);
+        }
+
+        for (const auto watch : watches)
+        {
+            m_Watches[watch].push_back(directory);
+        }
+
+        // only answer what a shim may run directly, anything else still has to go through Execute
+        m_Entries[directory] = entry.Direct ? entry.Resolved : std::nullopt;
+        return {};
+    }
+
+    /**
+     * Drain all pending inotify events, dropping the resolutions they affect. Results in true if the config or the
+     * version table changed, in which case everything has to be reloaded.
+     */
+    [[nodiscard]] bool Update()
+    {
+        alignas(inotify_event) char buffer[4096];
+
+        auto reload = false;
+
+        for (;;)
+        {
+            const auto count = read(m_Handle, buffer, sizeof(buffer));
+            if (count <= 0)
+            {
+                break;
+            }
+
+            for (ssize_t offset = 0; offset < count;)
+            {
+                const auto event = reinterpret_cast<const inotify_event *>(buffer + offset);
+                offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+                const std::string_view name = event->len ? event->name : "";
+
+                if (event->mask & IN_Q_OVERFLOW)
+                {
+                    reload = true;
+                }
+                else if (event->wd == m_DataWatch)
+                {
+                    reload |= name == "config.json" || name == "index.json" || !event->len;
+                }
+                else if (!event->len || name == unvm::VersionFileName || name == unvm::PackageFileName)
+                {
+                    Invalidate(event->wd);
+                }
+            }
+        }
+
+        return reload;
+    }
+
+private:
+    void Invalidate(const int watch)
+    {
+        const auto it = m_Watches.find(watch);
+        if (it == m_Watches.end())
+        {
+            return;
+        }
+
+        for (auto &directory : it->second)
+        {
+            m_Entries.erase(directory);
+        }
+
+        m_Watches.erase(it);
+    }
+
+    void Close()
+    {
+        if (m_Handle >= 0)
+        {
+            close(m_Handle);
+            m_Handle = -1;
+        }
+
+        m_DataWatch = -1;
+        m_Entries.clear();
+        m_Watches.clear();
+    }
+
+    int m_Handle = -1;
+    int m_DataWatch = -1;
+
+    std::unordered_map<std::string, std::optional<std::string>> m_Entries;
+    std::unordered_map<int, std::vector<std::string>> m_Watches;
+};
+
+[[nodiscard]] static toolkit::result<int> listen_socket(const std::string &path)
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+
+    if (path.size() >= sizeof(address.sun_path))
+    {
+        return toolkit::make_error("socket path '{}' is too long.", path);
+    }
+
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    // a socket file nobody accepts on is left over from a daemon that did not exit cleanly
+    if (const auto probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0); probe >= 0)
+    {
+        const auto connected = connect(probe, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) == 0;
+        close(probe);
+
+        if (connected)
+        {
+            return toolkit::make_error("a daemon is already running on '{}'.", path);
+        }
+    }
+
+    const auto handle = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (handle < 0)
+    {
+        return toolkit::make_error("failed to create socket: {}", std::strerror(errno));
+    }
+
+    unlink(path.c_str());
+
+    // only the owner of the data directory may ask, as the answers are exec'd without further checks
+    const auto mask = umask(0177);
+    const auto bound = bind(handle, reinterpret_cast<const sockaddr *>(&address), sizeof(address));
+    umask(mask);
+
+    if (bound < 0 || listen(handle, SOMAXCONN) < 0)
+    {
+        const auto error = errno;
+        close(handle);
+        return toolkit::make_error("failed to listen on '{}': {}", path, std::strerror(error));
+    }
+
+    return handle;
+}
+
+/**
+ * Read one request line from a client. Clients send it right after connecting, so a short timeout is enough to not
+ * let a stuck client block all others.
+ */
+static bool read_request(const int handle, std::string &directory)
+{
+    constexpr timeval timeout{ .tv_sec = 0, .tv_usec = 100000 };
+    setsockopt(handle, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    char buffer[512];
+    for (;;)
+    {
+        const auto count = recv(handle, buffer, sizeof(buffer), 0);
+        if (count <= 0)
+        {
+            return false;
+        }
+
+        directory.append(buffer, count);
+
+        if (const auto pos = directory.find('\n'); pos != std::string::npos)
+        {
+            directory.resize(pos);
+            return directory.starts_with('/');
+        }
+
+        if (directory.size() > PATH_MAX)
+        {
+            return false;
+        }
+    }
+}
+
+[[nodiscard]] static toolkit::result<> reload(
+    unvm::Config &config,
+    unvm::http::HttpClient &client,
+    std::optional<unvm::ResolutionContext> &resolution,
+    DaemonCache &cache)
+{
+    unvm::TraceSpan span("Daemon::Reload");
+
+    resolution.reset();
+
+    config = {};
+    if (auto res = unvm::ReadConfigFile(config); !res)
+    {
+        return res;
+    }
+
+    resolution.emplace(config, client);
+
+    // ranges, aliases and LTS names resolve against the table, so it is loaded and indexed once here and kept until
+    // index.json or the config change. if that fails, the next request that needs it tries again
+    if (auto res = resolution->Table(false, true); !res)
+    {
+        std::cerr << "warning: failed to load version table: " << res.error() << std::endl;
+    }
+
+    return cache.Reset();
+}
+
+/**
+ * Resolve the version active in the given directory, or answer from the cache. Exact pins are answered from the
+ * config, anything else from the version table the resolution context keeps. Results in an empty line unless an
+ * installed version is active there that a shim may run directly, so the shim falls back to resolving, installing or
+ * reporting errors on its own.
+ */
+[[nodiscard]] static toolkit::result<std::string> resolve(
+    unvm::Config &config,
+    unvm::ResolutionContext &resolution,
+    DaemonCache &cache,
+    const std::string &directory)
+{
+    unvm::TraceSpan span("Daemon::Resolve");
+
+    std::optional<std::string> version;
+
+    if (auto cached = cache.Find(directory))
+    {
+        version = *cached;
+    }
+    else
+    {
+        if (chdir(directory.c_str()) < 0)
+        {
+            return std::string("\n");
+        }
+
+        config.Detected.reset();
+        config.Active.reset();
+
+        unvm::ResolutionEntry resolved;
+        if (auto res = unvm::ResolveActiveVersion(config, resolution, resolved); !res)
+        {
+            return std::string("\n");
+        }
+
+        if (auto res = cache.Insert(directory, resolved); !res)
+        {
+            return res;
+        }
+
+        version = std::move(resolved.Resolved);
+    }
+
+    if (!version || !unvm::IsInstalled(config, *version))
+    {
+        return std::string("\n");
+    }
+
+    return *version + '\n';
+}
+
+toolkit::result<> unvm::Daemon(Config &config, http::HttpClient &client)
+{
+    const auto path = (GetDataDirectory() / DaemonSocketName).string();
+
+    int listener;
+    if (auto res = listen_socket(path) >> listener; !res)
+    {
+        return res;
+    }
+
+    struct sigaction action{};
+    action.sa_handler = request_stop;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+
+    auto guard_listener = toolkit::defer(
+        [listener, &path]
+        {
+            close(listener);
+            unlink(path.c_str());
+        });
+
+    std::optional<ResolutionContext> resolution;
+    DaemonCache cache;
+
+    if (auto res = reload(config, client, resolution, cache); !res)
+    {
+        return res;
+    }
+
+    std::cerr << "listening on '" << path << "'." << std::endl;
+
+    while (!stop_requested)
+    {
+        pollfd handles[2]
+        {
+            { .fd = listener, .events = POLLIN },
+            { .fd = cache.Handle(), .events = POLLIN },
+        };
+
+        if (poll(handles, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            return toolkit::make_error("failed to wait for requests: {}", std::strerror(errno));
+        }
+
+        // always drain the events first, a shim may be asking right after changing a marker file
+        if (cache.Update())
+        {
+            if (auto res = reload(config, client, resolution, cache); !res)
+            {
+                return res;
+            }
+        }
+
+        if (!(handles[0].revents & POLLIN))
+        {
+            continue;
+        }
+
+        const auto connection = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (connection < 0)
+        {
+            continue;
+        }
+
+        std::string directory;
+        if (read_request(connection, directory))
+        {
+            if (cache.Update())
+            {
+                if (auto res = reload(config, client, resolution, cache); !res)
+                {
+                    close(connection);
+                    return res;
+                }
+            }
+
+            std::string response;
+            if (auto res = resolve(config, *resolution, cache, directory) >> response; !res)
+            {
+                close(connection);
+                return res;
+            }
+
+            (void) send(connection, response.data(), response.size(), MSG_NOSIGNAL);
+        }
+
+        close(connection);
+    }
+
+    return {};
+}
+
+#else
+
+toolkit::result<> unvm::Daemon(Config &, http::HttpClient &)
+{
+    return toolkit::make_error("daemon mode is not supported on this platform.");
+}
+
+#endif
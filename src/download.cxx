@@ -0,0 +1,588 @@
+#include <unvm/trace.hxx>
+#include <unvm/util.hxx>
+#include <unvm/http/http.hxx>
+
+#include <toolkit/defer.hxx>
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+#if defined(SYSTEM_WINDOWS)
+
+#include <windows.h>
+
+using platform_file_t = HANDLE;
+
+static platform_file_t open_file(const std::filesystem::path &path)
+{
+    return CreateFileW(
+        path.c_str(),
+        GENERIC_WRITE,
+        FILE_SHARE_READ,
+        nullptr,
+        CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr);
+}
+
+static bool is_valid(const platform_file_t file)
+{
+    return file != INVALID_HANDLE_VALUE;
+}
+
+static void close_file(const platform_file_t file)
+{
+    CloseHandle(file);
+}
+
+static bool write_at(const platform_file_t file, const char *data, size_t size, uint64_t offset)
+{
+    while (size)
+    {
+        OVERLAPPED overlapped{};
+        overlapped.Offset = static_cast<DWORD>(offset);
+        overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+        DWORD written;
+        if (!WriteFile(file, data, static_cast<DWORD>(std::min<size_t>(size, 1 << 30)), &written, &overlapped))
+        {
+            return false;
+        }
+
+        data += written;
+        size -= written;
+        offset += written;
+    }
+
+    return true;
+}
+
+static bool resize_file(const platform_file_t file, const uint64_t size)
+{
+    FILE_END_OF_FILE_INFO info{};
+    info.EndOfFile.QuadPart = static_cast<LONGLONG>(size);
+    return SetFileInformationByHandle(file, FileEndOfFileInfo, &info, sizeof(info));
+}
+
+#else
+
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+using platform_file_t = int;
+
+static platform_file_t open_file(const std::filesystem::path &path)
+{
+    return open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+}
+
+static bool is_valid(const platform_file_t file)
+{
+    return file >= 0;
+}
+
+static void close_file(const platform_file_t file)
+{
+    close(file);
+}
+
+static bool write_at(const platform_file_t file, const char *data, size_t size, uint64_t offset)
+{
+    while (size)
+    {
+        const auto written = pwrite(file, data, size, static_cast<off_t>(offset));
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            return false;
+        }
+
+        data += written;
+        size -= written;
+        offset += written;
+    }
+
+    return true;
+}
+
+static bool resize_file(const platform_file_t file, const uint64_t size)
+{
+    return !ftruncate(file, static_cast<off_t>(size));
+}
+
+#endif
+
+/**
+ * Size of the first range, which doubles as the probe for range support, and of every range after it.
+ */
+static constexpr uint64_t segment_size = 2 << 20;
+
+static constexpr size_t max_connections = 8;
+static constexpr size_t max_redirects = 10;
+
+/**
+ * How often the throughput is measured to decide on adding another connection.
+ */
+static constexpr auto sample_interval = std::chrono::milliseconds(250);
+
+/**
+ * Stream buffer that writes at increasing offsets into a file shared with other writers, and rejects anything past the
+ * end of its range.
+ */
+struct RangeBuffer final : std::streambuf
+{
+    RangeBuffer(
+        const platform_file_t file,
+        const uint64_t offset,
+        const uint64_t end,
+        std::atomic<uint64_t> &received)
+        : file(file),
+          offset(offset),
+          end(end),
+          received(received)
+    {
+    }
+
+    std::streamsize xsputn(const char *data, const std::streamsize size) override
+    {
+        const auto len = static_cast<uint64_t>(size);
+        if (len > end - offset || !write_at(file, data, len, offset))
+        {
+            return 0;
+        }
+
+        offset += len;
+        received += len;
+        return size;
+    }
+
+    int_type overflow(const int_type c) override
+    {
+        if (traits_type::eq_int_type(c, traits_type::eof()))
+        {
+            return traits_type::not_eof(c);
+        }
+
+        const auto value = traits_type::to_char_type(c);
+        return xsputn(&value, 1) == 1 ? c : traits_type::eof();
+    }
+
+    platform_file_t file;
+    uint64_t offset;
+    uint64_t end;
+    std::atomic<uint64_t> &received;
+};
+
+/**
+ * Parse a content range header of the form 'bytes <first>-<last>/<total>'. An unknown total is not accepted, as the
+ * size is needed to split the rest of the file.
+ */
+[[nodiscard]] static bool parse_content_range(
+    const std::string_view value,
+    uint64_t &first,
+    uint64_t &last,
+    uint64_t &total)
+{
+    constexpr std::string_view prefix = "bytes ";
+    if (!value.starts_with(prefix))
+    {
+        return false;
+    }
+
+    const auto begin = value.data() + prefix.size();
+    const auto end = value.data() + value.size();
+
+    auto [dash, dash_ec] = std::from_chars(begin, end, first);
+    if (dash_ec != std::errc() || dash == end || *dash != '-')
+    {
+        return false;
+    }
+
+    auto [slash, slash_ec] = std::from_chars(dash + 1, end, last);
+    if (slash_ec != std::errc() || slash == end || *slash != '/')
+    {
+        return false;
+    }
+
+    auto [ptr, ec] = std::from_chars(slash + 1, end, total);
+    return ec == std::errc() && ptr == end && first <= last && last < total;
+}
+
+/**
+ * The ranges fetched over several connections are tied to the representation of the first one with If-Range, so a
+ * file that changes in between results in a full response instead of a mix of both versions. Only a strong ETag or a
+ * Last-Modified date can be used for that.
+ */
+static void set_if_range(unvm::http::HttpHeaders &headers, const unvm::http::HttpHeaders &response_headers)
+{
+    if (auto it = response_headers.find("etag"); it != response_headers.end() && !it->second.starts_with("W/"))
+    {
+        headers["If-Range"] = it->second;
+    }
+    else if (it = response_headers.find("last-modified"); it != response_headers.end())
+    {
+        headers["If-Range"] = it->second;
+    }
+}
+
+/**
+ * Shared state of the connections fetching the rest of a file after the first range.
+ */
+struct RangeDownload
+{
+    const unvm::http::HttpClient &client;
+    const unvm::http::URL &location;
+    unvm::http::HttpHeaders headers;
+
+    platform_file_t file;
+    uint64_t total;
+
+    std::atomic<uint64_t> next;
+    std::atomic<uint64_t> received;
+    std::atomic<size_t> running;
+    // set to make the next connection that finishes a range close, once the last one added did not pay off
+    std::atomic<bool> retire;
+
+    std::mutex mutex;
+    std::condition_variable done;
+    // the first failure of any connection, which stops all others
+    toolkit::result<> status;
+};
+
+[[nodiscard]] static toolkit::result<> fetch_range(RangeDownload &download, const uint64_t first, const uint64_t end)
+{
+    unvm::TraceSpan span("fetch_range");
+
+    unvm::http::HttpRequest request
+    {
+        .Method = unvm::http::HttpMethod::Get,
+        .Location = download.location,
+        .Headers = download.headers,
+    };
+
+    request.Headers["Range"] = std::format("bytes={}-{}", first, end - 1);
+
+    RangeBuffer buffer(download.file, first, end, download.received);
+    std::ostream stream(&buffer);
+
+    unvm::http::HttpResponse response
+    {
+        .Body = &stream,
+    };
+
+    // a failed fetch is tried once more, as the server may have closed a connection it did not want to keep open any
+    // longer. an unexpected answer is not going to change.
+    if (auto res = download.client.Fetch(request, response); !res)
+    {
+        // the bytes of the failed attempt are written again, and must not be counted twice
+        download.received -= buffer.offset - first;
+        buffer.offset = first;
+        stream.clear();
+
+        if (res = download.client.Fetch(request, response); !res)
+        {
+            return res;
+        }
+    }
+
+    if (response.StatusCode != unvm::http::HttpStatusCode::PartialContent)
+    {
+        return toolkit::make_error(
+            "server answered range request with {}, {}.",
+            response.StatusCode,
+            response.StatusMessage);
+    }
+
+    uint64_t range_first, range_last, range_total;
+    if (auto it = response.Headers.find("content-range");
+        it == response.Headers.end()
+        || !parse_content_range(it->second, range_first, range_last, range_total)
+        || range_first != first
+        || range_last != end - 1
+        || range_total != download.total)
+    {
+        return toolkit::make_error("server answered range request with a different range.");
+    }
+
+    if (!stream || buffer.offset != end)
+    {
+        return toolkit::make_error("failed to write range {}-{}.", first, end - 1);
+    }
+
+    return {};
+}
+
+/**
+ * Fetch ranges until there are none left or another connection failed.
+ */
+static void fetch_ranges(RangeDownload &download)
+{
+    for (;;)
+    {
+        {
+            std::lock_guard lock(download.mutex);
+            if (!download.status)
+            {
+                break;
+            }
+        }
+
+        const auto first = download.next.fetch_add(segment_size);
+        if (first >= download.total)
+        {
+            break;
+        }
+
+        const auto end = std::min(first + segment_size, download.total);
+
+        if (auto res = fetch_range(download, first, end); !res)
+        {
+            std::lock_guard lock(download.mutex);
+            if (download.status)
+            {
+                download.status = res;
+            }
+
+            break;
+        }
+
+        if (download.retire.exchange(false))
+        {
+            break;
+        }
+    }
+
+    std::lock_guard lock(download.mutex);
+    --download.running;
+    download.done.notify_all();
+}
+
+/**
+ * Fetch everything after the first range. Starts with two connections and adds one whenever the throughput of the
+ * last interval beat the best one seen so far by a tenth, so it stops growing once the link or the server is saturated.
+ * The interval right after adding a connection is skipped, as it is mostly spent on the handshake of the new one, and
+ * a connection that did not pay off is closed again.
+ */
+[[nodiscard]] static toolkit::result<> fetch_remaining(RangeDownload &download)
+{
+    unvm::TraceSpan span("fetch_remaining");
+
+    std::vector<std::thread> threads;
+
+    auto guard_threads = toolkit::defer(
+        [&threads]
+        {
+            for (auto &thread : threads)
+            {
+                thread.join();
+            }
+        });
+
+    auto add_connection = [&download, &threads]
+    {
+        ++download.running;
+        threads.emplace_back(fetch_ranges, std::ref(download));
+    };
+
+    add_connection();
+    add_connection();
+
+    double best_rate{};
+    auto growing = true;
+    auto settling = true;
+    auto last_received = download.received.load();
+    auto last_time = std::chrono::steady_clock::now();
+
+    std::unique_lock lock(download.mutex);
+
+    while (download.running)
+    {
+        download.done.wait_for(lock, sample_interval);
+
+        if (!growing || !download.status || download.next >= download.total)
+        {
+            continue;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        const auto received = download.received.load();
+
+        const auto rate = static_cast<double>(received - last_received)
+                          / std::chrono::duration<double>(now - last_time).count();
+
+        last_received = received;
+        last_time = now;
+
+        if (settling)
+        {
+            settling = false;
+            continue;
+        }
+
+        if (rate <= best_rate * 1.1)
+        {
+            growing = false;
+
+            // without a best rate, the initial connections stalled, and none of them was added on top
+            if (best_rate > 0)
+            {
+                download.retire = true;
+            }
+
+            continue;
+        }
+
+        best_rate = rate;
+
+        if (threads.size() >= max_connections)
+        {
+            growing = false;
+            continue;
+        }
+
+        add_connection();
+        settling = true;
+    }
+
+    return download.status;
+}
+
+toolkit::result<> unvm::http::Download(
+    const HttpClient &client,
+    URL location,
+    const std::filesystem::path &path,
+    HttpResponse &response)
+{
+    TraceSpan span("Download");
+
+    const auto file = open_file(path);
+    if (!is_valid(file))
+    {
+        return toolkit::make_error("failed to open '{}'.", path.string());
+    }
+
+    auto guard_file = toolkit::defer(close_file, file);
+
+    // byte ranges refer to the encoded body, so everything is fetched as is
+    const HttpHeaders headers
+    {
+        { "Accept-Encoding", "identity" },
+    };
+
+    std::atomic<uint64_t> received{};
+
+    // the first range tells whether the server supports ranges at all. if it does not, it answers with the whole file
+    // instead, which is written the same way
+    uint64_t written{};
+
+    for (size_t redirects = 0;; ++redirects)
+    {
+        HttpRequest request
+        {
+            .Method = HttpMethod::Get,
+            .Location = location,
+            .Headers = headers,
+        };
+
+        request.Headers["Range"] = std::format("bytes=0-{}", segment_size - 1);
+
+        RangeBuffer buffer(file, 0, ~uint64_t(), received);
+        std::ostream stream(&buffer);
+
+        response = { .Body = &stream };
+
+        if (auto res = client.Fetch(std::move(request), response); !res)
+        {
+            return res;
+        }
+
+        response.Body = nullptr;
+
+        if (!stream)
+        {
+            return toolkit::make_error("failed to write '{}'.", path.string());
+        }
+
+        written = buffer.offset;
+
+        if (!IsRedirect(response.StatusCode) || response.StatusCode == HttpStatusCode::NotModified)
+        {
+            break;
+        }
+
+        const auto it = response.Headers.find("location");
+        if (it == response.Headers.end())
+        {
+            return toolkit::make_error("missing location header in redirect response.");
+        }
+
+        if (redirects == max_redirects)
+        {
+            return toolkit::make_error("too many redirects.");
+        }
+
+        ApplyLocation(location, it->second);
+    }
+
+    if (response.StatusCode != HttpStatusCode::PartialContent)
+    {
+        // redirect bodies were written to the start of the file as well, so anything past this body is left over
+        if (!resize_file(file, IsSuccess(response.StatusCode) ? written : 0))
+        {
+            return toolkit::make_error("failed to resize '{}'.", path.string());
+        }
+
+        return {};
+    }
+
+    uint64_t first, last, total;
+    if (auto it = response.Headers.find("content-range");
+        it == response.Headers.end() || !parse_content_range(it->second, first, last, total) || first != 0)
+    {
+        return toolkit::make_error("invalid content range in response.");
+    }
+
+    if (written != last + 1)
+    {
+        return toolkit::make_error("failed to write '{}'.", path.string());
+    }
+
+    // allocate the whole file up front, as the ranges after the first arrive in any order
+    if (!resize_file(file, total))
+    {
+        return toolkit::make_error("failed to resize '{}'.", path.string());
+    }
+
+    if (total == written)
+    {
+        return {};
+    }
+
+    RangeDownload download
+    {
+        .client = client,
+        .location = location,
+        .headers = headers,
+        .file = file,
+        .total = total,
+    };
+
+    download.next = written;
+    download.received = written;
+
+    set_if_range(download.headers, response.Headers);
+
+    return fetch_remaining(download);
+}
@@ -0,0 +1,65 @@
+#include <unvm/util.hxx>
+
+#if defined(SYSTEM_LINUX) || defined(SYSTEM_ANDROID) || defined(SYSTEM_DARWIN)
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+static void to_file_stamp(const struct stat &st, unvm::FileStamp &stamp)
+{
+#if defined(SYSTEM_DARWIN)
+    const auto &time = st.st_mtimespec;
+#else
+    const auto &time = st.st_mtim;
+#endif
+
+    stamp.Time = static_cast<int64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+    stamp.Inode = st.st_ino;
+    stamp.Size = st.st_size;
+}
+
+bool unvm::GetFileStamp(const std::filesystem::path &path, FileStamp &stamp)
+{
+    struct stat st{};
+    if (stat(path.c_str(), &st))
+    {
+        return false;
+    }
+
+    to_file_stamp(st, stamp);
+    return true;
+}
+
+bool unvm::GetFileStamp(const int directory, const char *name, FileStamp &stamp)
+{
+    struct stat st{};
+    if (fstatat(directory, name, &st, 0))
+    {
+        return false;
+    }
+
+    to_file_stamp(st, stamp);
+    return true;
+}
+
+#endif
+
+#if defined(SYSTEM_WINDOWS)
+
+bool unvm::GetFileStamp(const std::filesystem::path &path, FileStamp &stamp)
+{
+    std::error_code ec;
+
+    const auto status = std::filesystem::status(path, ec);
+    if (ec || !std::filesystem::exists(status))
+    {
+        return false;
+    }
+
+    stamp.Time = std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+    stamp.Inode = 0;
+    stamp.Size = std::filesystem::is_regular_file(status) ? std::filesystem::file_size(path, ec) : 0;
+    return !ec;
+}
+
+#endif
@@ -1,4 +1,5 @@
-#include <unvm/json.hxx>
+#include <unvm/scanner.hxx>
+#include <unvm/trace.hxx>
 #include <unvm/util.hxx>
 
 #include <fstream>
@@ -19,58 +20,86 @@
 
 [[nodiscard]] static toolkit::result<std::optional<std::string>> read_package_version(const std::filesystem::path &path)
 {
-    std::ifstream stream(path);
+    std::ifstream stream(path, std::ios::binary);
     if (!stream)
     {
         return toolkit::make_error("failed to open '{}'.", path.string());
     }
 
-    json::Node node;
-    stream >> node;
-
-    if (!node)
+    std::optional<std::string> maybe;
+    if (auto res = unvm::FindJsonString(*stream.rdbuf(), { "engines", "node" }) >> maybe; !res)
     {
-        return toolkit::make_error("failed to parse '{}'.", path.string());
+        return toolkit::make_error("failed to read key 'engines.node' from '{}': {}", path.string(), res.error());
     }
 
-    std::optional<std::string> maybe;
-    if (!(node["engines"]["node"] >> maybe))
+    return maybe;
+}
+
+static void add_dependency(
+    unvm::FileDependencies *dependencies,
+    std::filesystem::path path,
+    const unvm::FileStamp &stamp)
+{
+    if (!dependencies)
     {
-        return toolkit::make_error("failed to convert key 'engines.node' in '{}' to string.", path.string());
+        return;
     }
 
-    return maybe;
+    dependencies->push_back({ .Path = std::move(path), .Stamp = stamp });
 }
 
 toolkit::result<std::optional<std::string>> unvm::FindActiveVersion(
     const std::optional<std::string> &def,
-    VersionType *type)
+    VersionType *type,
+    FileDependencies *dependencies)
 {
+    TraceSpan span("FindActiveVersion");
+
+    MarkerScanner scanner;
+    if (auto res = MarkerScanner::Open() >> scanner; !res)
+    {
+        return res;
+    }
+
     bool has_package_json{};
 
-    for (auto parent_path = std::filesystem::weakly_canonical(std::filesystem::current_path());;)
+    for (;;)
     {
-        if (!has_package_json)
+        // stamps are taken before reading, so a concurrent change can only make the recorded state look outdated
+        if (FileStamp stamp; dependencies)
         {
-            if (auto entry = parent_path / ".unvm"; std::filesystem::exists(entry))
+            if (!scanner.Stamp(stamp))
             {
-                std::string line;
-                if (auto res = read_exact_version(entry) >> line; !res)
-                {
-                    return res;
-                }
+                stamp = {};
+            }
 
-                if (type)
-                {
-                    *type = VersionType::Exact;
-                }
+            add_dependency(dependencies, scanner.Path(), stamp);
+        }
 
-                return { std::move(line) };
+        if (FileStamp stamp; !has_package_json && scanner.Find(VersionFileName, &stamp))
+        {
+            auto entry = scanner.Path(VersionFileName);
+            add_dependency(dependencies, entry, stamp);
+
+            std::string line;
+            if (auto res = read_exact_version(entry) >> line; !res)
+            {
+                return res;
             }
+
+            if (type)
+            {
+                *type = VersionType::Exact;
+            }
+
+            return { std::move(line) };
         }
 
-        if (auto entry = parent_path / "package.json"; std::filesystem::exists(entry))
+        if (FileStamp stamp; scanner.Find(PackageFileName, &stamp))
         {
+            auto entry = scanner.Path(PackageFileName);
+            add_dependency(dependencies, entry, stamp);
+
             std::optional<std::string> line;
             if (auto res = read_package_version(entry) >> line; !res)
             {
@@ -90,8 +119,7 @@ toolkit::result<std::optional<std::string>> unvm::FindActiveVersion(
             has_package_json = true;
         }
 
-        auto next = parent_path.parent_path();
-        if (next == parent_path)
+        if (!scanner.Up())
         {
             if (type)
             {
@@ -100,7 +128,5 @@ toolkit::result<std::optional<std::string>> unvm::FindActiveVersion(
 
             return def;
         }
-
-        parent_path = next;
     }
 }
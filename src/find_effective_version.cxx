@@ -1,102 +1,93 @@
+#include <unvm/lookup.hxx>
 #include <unvm/semver.hxx>
 #include <unvm/unvm.hxx>
-#include <unvm/util.hxx>
 
-#include <toolkit/string.hxx>
+#include <algorithm>
+#include <charconv>
 
-const unvm::VersionEntry *unvm::FindEffectiveVersion(
-    const VersionTable &table,
+/**
+ * Parse one to three dot-separated numeric parts, like '20', '20.11' or '20.11.1'.
+ */
+[[nodiscard]] static bool parse_parts(const std::string_view str, uint32_t (&parts)[3], unsigned &count)
+{
+    auto begin = str.data();
+    const auto end = str.data() + str.size();
+
+    for (count = 0; count < 3; ++count)
+    {
+        if (count && (begin == end || *begin++ != '.'))
+        {
+            return false;
+        }
+
+        auto [ptr, ec] = std::from_chars(begin, end, parts[count]);
+        if (ec != std::errc() || ptr == begin)
+        {
+            return false;
+        }
+
+        if ((begin = ptr) == end)
+        {
+            ++count;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+unvm::VersionEntry unvm::FindEffectiveVersion(
+    const VersionView &view,
+    const VersionLookup &lookup,
     const std::string_view version,
     bool &matched)
 {
+    auto at = [&view](const uint32_t row)
+    {
+        return row != VersionLookup::None ? view.Entry(row) : VersionEntry();
+    };
+
+    if (version.empty())
+    {
+        return {};
+    }
+
     // latest
     if (version == "latest")
     {
         matched = true;
-
-        if (!table.empty())
-        {
-            return &table.front();
-        }
-
-        return nullptr;
+        return at(lookup.Latest());
     }
 
     // latest lts
     if (version == "lts")
     {
         matched = true;
-
-        for (auto &entry : table)
-        {
-            if (entry.LTS)
-            {
-                return &entry;
-            }
-        }
-
-        return nullptr;
+        return at(lookup.LatestLTS());
     }
 
     // version by pattern
-    if (isdigit(version.front()))
+    if (isdigit(version.front()) || version.front() == 'v')
     {
-        switch (const auto segments = toolkit::split(version, '.'); segments.size())
+        uint32_t parts[3];
+        unsigned count;
+        if (!parse_parts(version.front() == 'v' ? version.substr(1) : version, parts, count))
         {
-        case 1:
-        case 2:
-            for (const auto pattern = 'v' + std::string(version) + '.';
-                 auto &entry : table)
-            {
-                if (entry.Version.starts_with(pattern))
-                {
-                    return &entry;
-                }
-            }
-            break;
-
-        case 3:
-            for (const auto pattern = 'v' + std::string(version);
-                 auto &entry : table)
-            {
-                if (entry.Version == pattern)
-                {
-                    return &entry;
-                }
-            }
-            break;
-
-        default:
-            break;
+            return {};
         }
 
-        return nullptr;
-    }
-
-    // version by pattern
-    if (version.front() == 'v')
-    {
-        switch (const auto segments = toolkit::split(version, '.'); segments.size())
+        switch (count)
         {
         case 1:
+            return at(lookup.Major(parts[0]));
+
         case 2:
-            for (const auto pattern = std::string(version) + '.';
-                 auto &entry : table)
-            {
-                if (entry.Version.starts_with(pattern))
-                {
-                    return &entry;
-                }
-            }
-            break;
+            return at(lookup.Minor(parts[0], parts[1]));
 
         case 3:
-            for (auto &entry : table)
+            if (uint64_t key; semver::PackVersion(parts[0], parts[1], parts[2], key))
             {
-                if (entry.Version == version)
-                {
-                    return &entry;
-                }
+                return at(lookup.Exact(key));
             }
             break;
 
@@ -104,35 +95,27 @@ const unvm::VersionEntry *unvm::FindEffectiveVersion(
             break;
         }
 
-        return nullptr;
+        return {};
     }
 
     // lts by name
-    const auto name = toolkit::lowercase(std::string(version));
-    for (auto &entry : table)
-    {
-        if (entry.LTS && toolkit::lowercase(*entry.LTS) == name)
-        {
-            return &entry;
-        }
-    }
-
-    return nullptr;
+    return at(lookup.Codename(version));
 }
 
-toolkit::result<const unvm::VersionEntry *> unvm::FindVersionEntry(
-    const VersionTable &table,
+toolkit::result<unvm::VersionEntry> unvm::FindVersionEntry(
+    const VersionView &view,
+    const VersionLookup &lookup,
     const std::string_view version)
 {
     bool matched{};
-    if (auto *effective = FindEffectiveVersion(table, version, matched))
+    if (auto effective = FindEffectiveVersion(view, lookup, version, matched))
     {
         return effective;
     }
 
     if (matched)
     {
-        return nullptr;
+        return VersionEntry();
     }
 
     semver::RangeSet set;
@@ -141,19 +124,66 @@ toolkit::result<const unvm::VersionEntry *> unvm::FindVersionEntry(
         return res;
     }
 
-    for (auto &entry : table)
+    auto &table = view.Table();
+
+    const auto rows = view.Rows();
+    auto begin = rows.begin();
+
+    // views keep table order, so the keys of their rows are sorted just like the table
+    auto key = [&table](const uint32_t row)
+    {
+        return table.Key(row);
+    };
+
+    if (semver::IntervalSet intervals; semver::CompileRangeSet(set, intervals))
     {
+        // packed entries come first, newest first, so the newest match is the first one below the end of the highest
+        // interval that still lies inside of it
+        const auto packed_end = std::ranges::partition_point(
+            rows,
+            [](const uint64_t value)
+            {
+                return value;
+            },
+            key);
+
+        for (auto it = intervals.rbegin(); it != intervals.rend(); ++it)
+        {
+            begin = std::ranges::partition_point(
+                begin,
+                packed_end,
+                [end = it->End](const uint64_t value)
+                {
+                    return value >= end;
+                },
+                key);
+
+            if (begin != packed_end && key(*begin) >= it->Begin)
+            {
+                return view.Entry(*begin);
+            }
+        }
+
+        begin = packed_end;
+    }
+
+    for (auto it = begin; it != rows.end(); ++it)
+    {
+        const auto value = table.Key(*it);
+
         bool in_range;
-        if (auto res = IsInRange(set, entry.Version) >> in_range; !res)
+        if (auto res = (value
+                            ? IsInRange(set, semver::UnpackVersion(value))
+                            : IsInRange(set, table.Version(*it))) >> in_range; !res)
         {
             return res;
         }
 
         if (in_range)
         {
-            return &entry;
+            return view.Entry(*it);
         }
     }
 
-    return nullptr;
+    return VersionEntry();
 }
@@ -0,0 +1,393 @@
+#include <unvm/util.hxx>
+
+#include <streambuf>
+
+using traits = std::streambuf::traits_type;
+
+static void skip_whitespace(std::streambuf &buffer)
+{
+    for (auto c = buffer.sgetc(); c == ' ' || c == '\t' || c == '\n' || c == '\r'; c = buffer.snextc())
+    {
+    }
+}
+
+static bool is_literal(const int c)
+{
+    return ('a' <= c && c <= 'z')
+           || ('A' <= c && c <= 'Z')
+           || ('0' <= c && c <= '9')
+           || c == '+'
+           || c == '-'
+           || c == '.';
+}
+
+[[nodiscard]] static bool read_hex(std::streambuf &buffer, uint32_t &value)
+{
+    value = 0;
+
+    for (auto i = 0; i < 4; ++i)
+    {
+        const auto c = buffer.sbumpc();
+
+        value <<= 4;
+
+        if ('0' <= c && c <= '9')
+        {
+            value |= c - '0';
+        }
+        else if ('a' <= c && c <= 'f')
+        {
+            value |= c - 'a' + 10;
+        }
+        else if ('A' <= c && c <= 'F')
+        {
+            value |= c - 'A' + 10;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template<typename S>
+static void write_utf8(const uint32_t code_point, S &&sink)
+{
+    if (code_point < 0x80)
+    {
+        sink(static_cast<char>(code_point));
+    }
+    else if (code_point < 0x800)
+    {
+        sink(static_cast<char>(0xC0 | (code_point >> 6)));
+        sink(static_cast<char>(0x80 | (code_point & 0x3F)));
+    }
+    else if (code_point < 0x10000)
+    {
+        sink(static_cast<char>(0xE0 | (code_point >> 12)));
+        sink(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+        sink(static_cast<char>(0x80 | (code_point & 0x3F)));
+    }
+    else
+    {
+        sink(static_cast<char>(0xF0 | (code_point >> 18)));
+        sink(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+        sink(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+        sink(static_cast<char>(0x80 | (code_point & 0x3F)));
+    }
+}
+
+/**
+ * Read a string token and pass its decoded characters to sink, one at a time.
+ */
+template<typename S>
+[[nodiscard]] static bool read_string(std::streambuf &buffer, S &&sink)
+{
+    if (buffer.sbumpc() != '"')
+    {
+        return false;
+    }
+
+    for (;;)
+    {
+        auto c = buffer.sbumpc();
+
+        if (c == traits::eof())
+        {
+            return false;
+        }
+
+        if (c == '"')
+        {
+            return true;
+        }
+
+        if (c != '\\')
+        {
+            sink(static_cast<char>(c));
+            continue;
+        }
+
+        switch (c = buffer.sbumpc())
+        {
+        case '"':
+        case '\\':
+        case '/':
+            sink(static_cast<char>(c));
+            break;
+
+        case 'b':
+            sink('\b');
+            break;
+
+        case 'f':
+            sink('\f');
+            break;
+
+        case 'n':
+            sink('\n');
+            break;
+
+        case 'r':
+            sink('\r');
+            break;
+
+        case 't':
+            sink('\t');
+            break;
+
+        case 'u':
+        {
+            uint32_t code_point;
+            if (!read_hex(buffer, code_point))
+            {
+                return false;
+            }
+
+            if (0xD800 <= code_point && code_point <= 0xDBFF)
+            {
+                uint32_t low;
+                if (buffer.sbumpc() != '\\' || buffer.sbumpc() != 'u' || !read_hex(buffer, low))
+                {
+                    return false;
+                }
+
+                if (low < 0xDC00 || 0xDFFF < low)
+                {
+                    return false;
+                }
+
+                code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+            }
+
+            write_utf8(code_point, sink);
+            break;
+        }
+
+        default:
+            return false;
+        }
+    }
+}
+
+/**
+ * Skip a complete value of any kind. Nested values are skipped by tracking the bracket depth only, so objects and
+ * arrays are never materialized, and only strings need to be tokenized.
+ */
+[[nodiscard]] static bool skip_value(std::streambuf &buffer)
+{
+    size_t depth = 0;
+
+    do
+    {
+        skip_whitespace(buffer);
+
+        switch (const auto c = buffer.sgetc())
+        {
+        case '"':
+            if (!read_string(buffer, [](char) {}))
+            {
+                return false;
+            }
+            break;
+
+        case '{':
+        case '[':
+            ++depth;
+            buffer.sbumpc();
+            break;
+
+        case '}':
+        case ']':
+            if (!depth)
+            {
+                return false;
+            }
+
+            --depth;
+            buffer.sbumpc();
+            break;
+
+        case ',':
+        case ':':
+            if (!depth)
+            {
+                return false;
+            }
+
+            buffer.sbumpc();
+            break;
+
+        default:
+            if (!is_literal(c))
+            {
+                return false;
+            }
+
+            while (is_literal(buffer.sgetc()))
+            {
+                buffer.sbumpc();
+            }
+            break;
+        }
+    }
+    while (depth);
+
+    return true;
+}
+
+/**
+ * Read a literal and check that it is null.
+ */
+[[nodiscard]] static bool read_null(std::streambuf &buffer)
+{
+    char literal[6]{};
+    for (size_t i = 0; i < sizeof(literal) - 1 && is_literal(buffer.sgetc()); ++i)
+    {
+        literal[i] = static_cast<char>(buffer.sbumpc());
+    }
+
+    return std::string_view(literal) == "null" && !is_literal(buffer.sgetc());
+}
+
+/**
+ * Find the rest of the path in the object at the current position. Like a DOM, the last of several equal keys wins, so
+ * the object is always read to its end, but only the members that match are looked into.
+ */
+[[nodiscard]] static toolkit::result<std::optional<std::string>> find_in_object(
+    std::streambuf &buffer,
+    const std::string_view *key,
+    const std::string_view *end)
+{
+    std::optional<std::string> result;
+
+    buffer.sbumpc();
+    skip_whitespace(buffer);
+
+    if (buffer.sgetc() == '}')
+    {
+        buffer.sbumpc();
+        return result;
+    }
+
+    for (;;)
+    {
+        skip_whitespace(buffer);
+
+        if (buffer.sgetc() != '"')
+        {
+            return toolkit::make_error("malformed json, expected key.");
+        }
+
+        const auto expected = *key;
+
+        size_t index = 0;
+        auto match = true;
+
+        if (!read_string(
+            buffer,
+            [&](const char c)
+            {
+                match = match && index < expected.size() && expected[index] == c;
+                ++index;
+            }))
+        {
+            return toolkit::make_error("malformed json, invalid key.");
+        }
+
+        match = match && index == expected.size();
+
+        skip_whitespace(buffer);
+
+        if (buffer.sbumpc() != ':')
+        {
+            return toolkit::make_error("malformed json, expected ':'.");
+        }
+
+        skip_whitespace(buffer);
+
+        if (match && key + 1 == end)
+        {
+            if (buffer.sgetc() == '"')
+            {
+                std::string value;
+                if (!read_string(
+                    buffer,
+                    [&value](const char c)
+                    {
+                        value += c;
+                    }))
+                {
+                    return toolkit::make_error("malformed json, invalid string.");
+                }
+
+                result = std::move(value);
+            }
+            else if (read_null(buffer))
+            {
+                result = std::nullopt;
+            }
+            else
+            {
+                return toolkit::make_error("value is not a string.");
+            }
+        }
+        else if (match)
+        {
+            if (buffer.sgetc() == '{')
+            {
+                if (auto res = find_in_object(buffer, key + 1, end) >> result; !res)
+                {
+                    return res;
+                }
+            }
+            else if (read_null(buffer))
+            {
+                result = std::nullopt;
+            }
+            else
+            {
+                return toolkit::make_error("value is not an object.");
+            }
+        }
+        else if (!skip_value(buffer))
+        {
+            return toolkit::make_error("malformed json, invalid value.");
+        }
+
+        skip_whitespace(buffer);
+
+        switch (buffer.sbumpc())
+        {
+        case ',':
+            break;
+
+        case '}':
+            return result;
+
+        default:
+            return toolkit::make_error("malformed json, expected ',' or '}'.");
+        }
+    }
+}
+
+toolkit::result<std::optional<std::string>> unvm::FindJsonString(
+    std::streambuf &buffer,
+    const std::initializer_list<std::string_view> path)
+{
+    skip_whitespace(buffer);
+
+    if (buffer.sgetc() != '{')
+    {
+        return toolkit::make_error("malformed json, expected object.");
+    }
+
+    if (!path.size())
+    {
+        return { std::nullopt };
+    }
+
+    return find_in_object(buffer, path.begin(), path.end());
+}
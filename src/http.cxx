@@ -1,4 +1,5 @@
 #include <unvm/data.hxx>
+#include <unvm/trace.hxx>
 #include <unvm/util.hxx>
 #include <unvm/http/http.hxx>
 #include <unvm/http/url.hxx>
@@ -8,64 +9,80 @@
 
 #include <openssl/crypto.h>
 #include <openssl/err.h>
+#include <openssl/evp.h>
 #include <openssl/ssl.h>
 
+#include <zlib.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <istream>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <ostream>
+#include <ranges>
 #include <sstream>
+#include <vector>
 
 #ifdef SYSTEM_WINDOWS
 
+#include <process.h>
 #include <winsock2.h>
 #include <ws2tcpip.h>
 
+#define getpid _getpid
+
 using platform_socket_t = SOCKET;
 
+constexpr int send_flags = 0;
+
 inline int socket_close(platform_socket_t s)
 {
     return closesocket(s);
 }
 
+inline int socket_poll(pollfd *fds, const unsigned long count, const int timeout)
+{
+    return WSAPoll(fds, count, timeout);
+}
+
 #endif
 
 #if defined(SYSTEM_LINUX) || defined(SYSTEM_ANDROID) || defined(SYSTEM_DARWIN)
 
 #include <netdb.h>
+#include <poll.h>
 #include <unistd.h>
 #include <sys/socket.h>
 
 using platform_socket_t = int;
 
+// a reused connection may have been reset by the server, which must surface as an error and not as SIGPIPE
+#ifdef MSG_NOSIGNAL
+constexpr int send_flags = MSG_NOSIGNAL;
+#else
+constexpr int send_flags = 0;
+#endif
+
 inline int socket_close(const platform_socket_t s)
 {
     return close(s);
 }
 
-#endif
-
-[[nodiscard]] static toolkit::result<> read_until(
-    unvm::http::HttpTransport *transport,
-    std::string &dst,
-    const char *delim)
+inline int socket_poll(pollfd *fds, const nfds_t count, const int timeout)
 {
-    char chunk[1024];
-
-    while (dst.find(delim) == std::string::npos)
-    {
-        const auto len = transport->read(chunk);
-        if (len <= 0)
-        {
-            return toolkit::make_error("failed to read chunk.");
-        }
-
-        dst.insert(dst.end(), chunk, chunk + len);
-    }
-
-    return {};
+    return poll(fds, count, timeout);
 }
 
+#endif
+
 static void set_header_if_missing(unvm::http::HttpHeaders &headers, const std::string &key, const std::string &val)
 {
     if (headers.contains(key) || headers.contains(toolkit::lowercase(key)))
@@ -133,7 +150,7 @@ struct HttpTcpTransport final : unvm::http::HttpTransport
 
     int write(const std::span<const char> buffer) override
     {
-        return static_cast<int>(send(sock, buffer.data(), buffer.size(), 0));
+        return static_cast<int>(send(sock, buffer.data(), buffer.size(), send_flags));
     }
 
     int read(const std::span<char> buffer) override
@@ -164,14 +181,280 @@ struct HttpTlsTransport final : unvm::http::HttpTransport
     SSL *ssl;
 };
 
+/**
+ * One open connection, with the bytes that were read past the end of the last thing parsed from it.
+ */
+struct HttpConnection
+{
+    HttpConnection(const platform_socket_t sock, SSL *ssl)
+        : sock(sock),
+          ssl(ssl)
+    {
+        if (ssl)
+        {
+            transport = std::make_unique<HttpTlsTransport>(ssl);
+        }
+        else
+        {
+            transport = std::make_unique<HttpTcpTransport>(sock);
+        }
+    }
+
+    ~HttpConnection()
+    {
+        if (ssl)
+        {
+            // without a shutdown, OpenSSL marks the session as not resumable. a quiet one does not write to a socket
+            // the server may have closed already.
+            SSL_set_quiet_shutdown(ssl, 1);
+            SSL_shutdown(ssl);
+            SSL_free(ssl);
+        }
+
+        socket_close(sock);
+    }
+
+    HttpConnection(const HttpConnection &) = delete;
+    HttpConnection &operator=(const HttpConnection &) = delete;
+
+    /**
+     * An idle connection must not have anything to read. If it does, the server closed it or sent something unasked,
+     * and either way it cannot carry another request.
+     */
+    [[nodiscard]] bool is_idle()
+    {
+        pollfd fd{ .fd = sock, .events = POLLIN };
+        return pending.empty() && socket_poll(&fd, 1, 0) == 0;
+    }
+
+    int read(const std::span<char> buffer)
+    {
+        if (pending.empty())
+        {
+            return transport->read(buffer);
+        }
+
+        const auto len = std::min(buffer.size(), pending.size());
+        std::memcpy(buffer.data(), pending.data(), len);
+        pending.erase(0, len);
+
+        return static_cast<int>(len);
+    }
+
+    /**
+     * Read up to the next delimiter, and consume it.
+     */
+    [[nodiscard]] toolkit::result<> read_until(std::string &dst, const std::string_view delim)
+    {
+        size_t pos;
+        while ((pos = pending.find(delim)) == std::string::npos)
+        {
+            char chunk[1024];
+
+            const auto len = transport->read(chunk);
+            if (len <= 0)
+            {
+                return toolkit::make_error("failed to read chunk.");
+            }
+
+            pending.append(chunk, len);
+        }
+
+        dst.assign(pending, 0, pos);
+        pending.erase(0, pos + delim.size());
+        return {};
+    }
+
+    platform_socket_t sock;
+    SSL *ssl;
+    std::unique_ptr<unvm::http::HttpTransport> transport;
+    std::string pending;
+};
+
+/**
+ * Connections that can be reused are kept per scheme, host and port, for as long as the client lives. TLS sessions
+ * are kept as well, so a new connection to a host that closed the last one can still skip the full handshake. They are
+ * also stored as tls.cache in the data directory, which lets the next process resume them.
+ */
 struct unvm::http::HttpClient::State
 {
+    static constexpr size_t MaxIdle = 4;
+
 #ifdef SYSTEM_WINDOWS
     WSADATA wsa;
 #endif
-    SSL_CTX *ssl;
+    std::span<const uint8_t> certificates;
+    SSL_CTX *ssl{};
+
+    // guards everything below, so requests can be made from several threads at once
+    std::mutex mutex;
+
+    std::map<std::string, std::vector<std::unique_ptr<HttpConnection>>> idle;
+    std::map<std::string, SSL_SESSION *> sessions;
+
+    // serializes writing tls.cache, as all threads of a process share one temp file. never held with mutex
+    std::mutex store_mutex;
 };
 
+static constexpr std::string_view session_magic = "unvm-tls\t1";
+
+static std::filesystem::path get_session_cache_path()
+{
+    return unvm::GetDataDirectory() / "tls.cache";
+}
+
+/**
+ * Read the entries of the session cache that have not expired yet, by key. Each line of the file holds the key of the
+ * connection, the unix time the session expires at and the DER encoded session in base64, separated by tabs.
+ */
+static std::map<std::string, std::string> read_session_lines(const std::filesystem::path &path)
+{
+    std::map<std::string, std::string> lines;
+
+    std::ifstream stream(path);
+
+    std::string line;
+    if (!std::getline(stream, line) || line != session_magic)
+    {
+        return lines;
+    }
+
+    const auto now = static_cast<int64_t>(std::time(nullptr));
+
+    while (std::getline(stream, line))
+    {
+        const auto first = line.find('\t');
+        const auto second = line.find('\t', first + 1);
+        if (second == std::string::npos)
+        {
+            continue;
+        }
+
+        int64_t expiry;
+        if (auto [ptr, ec] = std::from_chars(line.data() + first + 1, line.data() + second, expiry);
+            ec != std::errc() || ptr != line.data() + second || expiry <= now)
+        {
+            continue;
+        }
+
+        auto key = line.substr(0, first);
+        lines[std::move(key)] = std::move(line);
+    }
+
+    return lines;
+}
+
+static SSL_SESSION *decode_session(const std::string_view encoded)
+{
+    std::vector<unsigned char> der(encoded.size() / 4 * 3);
+
+    const auto len = EVP_DecodeBlock(
+        der.data(),
+        reinterpret_cast<const unsigned char *>(encoded.data()),
+        static_cast<int>(encoded.size()));
+    if (len <= 0)
+    {
+        return nullptr;
+    }
+
+    // the decoded length includes the padding, which d2i ignores as the DER encoding carries its own length
+    const unsigned char *ptr = der.data();
+    return d2i_SSL_SESSION(nullptr, &ptr, len);
+}
+
+/**
+ * Load the sessions other processes stored for resumption.
+ */
+static void load_sessions(std::map<std::string, SSL_SESSION *> &sessions)
+{
+    unvm::TraceSpan span("load_sessions");
+
+    for (auto &[key, line] : read_session_lines(get_session_cache_path()))
+    {
+        const auto session = decode_session(std::string_view(line).substr(line.rfind('\t') + 1));
+        if (!session)
+        {
+            continue;
+        }
+
+        auto &slot = sessions[key];
+        if (slot)
+        {
+            SSL_SESSION_free(slot);
+        }
+
+        slot = session;
+    }
+}
+
+/**
+ * Store a session for the given key in the session cache, keeping the unexpired entries of all other keys. The file
+ * holds the secrets to resume the sessions, so only the owner may read it.
+ */
+[[nodiscard]] static toolkit::result<> store_session(const std::string &key, SSL_SESSION *session)
+{
+    unvm::TraceSpan span("store_session");
+
+    const auto len = i2d_SSL_SESSION(session, nullptr);
+    if (len <= 0)
+    {
+        return toolkit::make_error("failed to encode TLS session.");
+    }
+
+    std::vector<unsigned char> der(len);
+    auto der_ptr = der.data();
+    i2d_SSL_SESSION(session, &der_ptr);
+
+    std::string encoded(4 * ((len + 2) / 3), '\0');
+    EVP_EncodeBlock(reinterpret_cast<unsigned char *>(encoded.data()), der.data(), len);
+
+    const auto expiry = static_cast<int64_t>(SSL_SESSION_get_time(session))
+                        + static_cast<int64_t>(SSL_SESSION_get_timeout(session));
+
+    const auto path = get_session_cache_path();
+
+    auto lines = read_session_lines(path);
+    lines[key] = std::format("{}\t{}\t{}", key, expiry, encoded);
+
+    auto temp_path = path;
+    temp_path += std::format(".{}", getpid());
+
+    {
+        std::ofstream stream(temp_path, std::ios::trunc);
+        if (!stream)
+        {
+            return toolkit::make_error("failed to open '{}'.", temp_path.string());
+        }
+
+        std::error_code ec;
+        std::filesystem::permissions(
+            temp_path,
+            std::filesystem::perms::owner_read | std::filesystem::perms::owner_write,
+            ec);
+
+        stream << session_magic << '\n';
+        for (auto &line : lines | std::views::values)
+        {
+            stream << line << '\n';
+        }
+
+        if (!stream)
+        {
+            return toolkit::make_error("failed to write '{}'.", temp_path.string());
+        }
+    }
+
+    if (std::error_code ec; unvm::RenameFile(temp_path, path, ec), ec)
+    {
+        std::error_code remove_ec;
+        std::filesystem::remove(temp_path, remove_ec);
+
+        return toolkit::make_error("failed to rename TLS session cache: {} ({}).", ec.message(), ec.value());
+    }
+
+    return {};
+}
+
 [[nodiscard]] static toolkit::result<> load_vendor_certificates(
     const SSL_CTX *context,
     const std::span<const uint8_t> buffer)
@@ -228,27 +511,33 @@ struct unvm::http::HttpClient::State
 }
 
 unvm::http::HttpClient::HttpClient()
+    : HttpClient(data::cacert)
+{
+}
+
+unvm::http::HttpClient::HttpClient(const std::span<const uint8_t> certificates)
 {
     m_State = new State();
+    m_State->certificates = certificates;
 
 #ifdef SYSTEM_WINDOWS
     WSAStartup(MAKEWORD(2, 2), &m_State->wsa);
 #endif
+}
 
-    m_State->ssl = SSL_CTX_new(TLS_client_method());
-    SSL_CTX_set_min_proto_version(m_State->ssl, TLS1_2_VERSION);
-    SSL_CTX_set_verify(m_State->ssl, SSL_VERIFY_PEER, nullptr);
+unvm::http::HttpClient::~HttpClient()
+{
+    m_State->idle.clear();
 
-    if (auto res = load_vendor_certificates(m_State->ssl, data::cacert); !res)
+    for (auto &session : m_State->sessions | std::views::values)
     {
-        std::cerr << "failed to load vendor certificates: " << res.error() << std::endl;
-        return;
+        SSL_SESSION_free(session);
     }
-}
 
-unvm::http::HttpClient::~HttpClient()
-{
-    SSL_CTX_free(m_State->ssl);
+    if (m_State->ssl)
+    {
+        SSL_CTX_free(m_State->ssl);
+    }
 
 #ifdef SYSTEM_WINDOWS
     WSACleanup();
@@ -258,14 +547,46 @@ unvm::http::HttpClient::~HttpClient()
     m_State = nullptr;
 }
 
-toolkit::result<> unvm::http::HttpClient::Fetch(HttpRequest request, HttpResponse &response) const
+toolkit::result<> unvm::http::HttpClient::InitTLS() const
 {
-    if (request.Location.Scheme != "http" && request.Location.Scheme != "https")
+    std::lock_guard lock(m_State->mutex);
+
+    if (m_State->ssl)
     {
-        return toolkit::make_error("unsupported scheme '{}'", request.Location.Scheme);
+        return {};
     }
 
-    auto service = std::to_string(request.Location.Port);
+    TraceSpan span("HttpClient::InitTLS");
+
+    const auto ssl = SSL_CTX_new(TLS_client_method());
+    if (!ssl)
+    {
+        return toolkit::make_error("failed to create TLS context: {}", GetSSLErrorStack());
+    }
+
+    SSL_CTX_set_min_proto_version(ssl, TLS1_2_VERSION);
+    SSL_CTX_set_verify(ssl, SSL_VERIFY_PEER, nullptr);
+
+    if (auto res = load_vendor_certificates(ssl, m_State->certificates); !res)
+    {
+        SSL_CTX_free(ssl);
+        return toolkit::make_error("failed to load vendor certificates: {}", res.error());
+    }
+
+    m_State->ssl = ssl;
+
+    load_sessions(m_State->sessions);
+    return {};
+}
+
+[[nodiscard]] static toolkit::result<std::unique_ptr<HttpConnection>> open_connection(
+    const unvm::http::URL &location,
+    SSL_CTX *context,
+    SSL_SESSION *session)
+{
+    unvm::TraceSpan span("open_connection");
+
+    auto service = std::to_string(location.Port);
 
     addrinfo hints
     {
@@ -275,7 +596,7 @@ toolkit::result<> unvm::http::HttpClient::Fetch(HttpRequest request, HttpRespons
     };
 
     addrinfo *info{};
-    if (auto error = getaddrinfo(request.Location.Host.c_str(), service.c_str(), &hints, &info))
+    if (auto error = getaddrinfo(location.Host.c_str(), service.c_str(), &hints, &info))
     {
         return toolkit::make_error("failed to get address info ({}).", error);
     }
@@ -307,49 +628,298 @@ toolkit::result<> unvm::http::HttpClient::Fetch(HttpRequest request, HttpRespons
         return toolkit::make_error("failed to open socket.");
     }
 
-    std::unique_ptr<HttpTransport> transport;
-    SSL *ssl{};
+#ifdef SO_NOSIGPIPE
+    constexpr int on = 1;
+    setsockopt(sock, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+
+    if (location.Scheme != "https")
+    {
+        return std::make_unique<HttpConnection>(sock, nullptr);
+    }
+
+    const auto ssl = SSL_new(context);
+    auto connection = std::make_unique<HttpConnection>(sock, ssl);
+
+    SSL_set_fd(ssl, sock);
+
+    SSL_set_tlsext_host_name(ssl, location.Host.c_str());
+    SSL_set1_host(ssl, location.Host.c_str());
+    SSL_set_verify(ssl, SSL_VERIFY_PEER, nullptr);
+
+    if (session)
+    {
+        SSL_set_session(ssl, session);
+    }
+
+    if (auto result = SSL_connect(ssl); result <= 0)
+    {
+        return toolkit::make_error("TLS handshake failed.");
+    }
+
+    if (SSL_get_verify_result(ssl) != X509_V_OK)
+    {
+        return toolkit::make_error("TLS certificate verification failed.");
+    }
+
+    return connection;
+}
+
+/**
+ * Stream buffer that inflates gzip, zlib or raw deflate data as it is written, passing the output on to another stream
+ * through a fixed buffer, so a compressed body is never held in memory as a whole. Concatenated gzip members are
+ * decoded one after another.
+ */
+struct InflateBuffer final : std::streambuf
+{
+    explicit InflateBuffer(std::ostream &target)
+        : target(target)
+    {
+        // 32 enables detection of the gzip or zlib header
+        ready = inflateInit2(&stream, 15 + 32) == Z_OK;
+    }
+
+    ~InflateBuffer() override
+    {
+        if (ready)
+        {
+            inflateEnd(&stream);
+        }
+    }
+
+    InflateBuffer(const InflateBuffer &) = delete;
+    InflateBuffer &operator=(const InflateBuffer &) = delete;
 
-    auto guard0 = toolkit::defer(socket_close, sock);
-    auto guard1 = toolkit::defer(
-        [](auto *s)
+    std::streamsize xsputn(const char *data, const std::streamsize size) override
+    {
+        if (!ready)
         {
-            if (s)
+            return 0;
+        }
+
+        if (!detecting)
+        {
+            return decode(data, size) == Z_OK ? size : 0;
+        }
+
+        // the first two bytes tell a zlib or gzip header from raw deflate, so they are held back until both are in
+        head.append(data, size);
+        if (head.size() < 2)
+        {
+            return size;
+        }
+
+        detecting = false;
+
+        auto status = decode(head.data(), head.size());
+
+        // some servers send raw deflate for 'deflate'. that fails the header check before anything was decoded, so
+        // the body is started over without a header
+        if (status == Z_DATA_ERROR && !stream.total_out)
+        {
+            status = inflateReset2(&stream, -MAX_WBITS);
+            if (status == Z_OK)
             {
-                SSL_free(s);
+                status = decode(head.data(), head.size());
             }
-        },
-        ssl);
+        }
 
-    if (request.Location.Scheme == "https")
+        head.clear();
+        head.shrink_to_fit();
+
+        return status == Z_OK ? size : 0;
+    }
+
+    int_type overflow(const int_type c) override
+    {
+        if (traits_type::eq_int_type(c, traits_type::eof()))
+        {
+            return traits_type::not_eof(c);
+        }
+
+        const auto value = traits_type::to_char_type(c);
+        return xsputn(&value, 1) == 1 ? c : traits_type::eof();
+    }
+
+    /**
+     * Inflate the input and write the output to the target.
+     *
+     * @param data The compressed data.
+     * @param size The size of the compressed data.
+     * @return Z_OK if all input was consumed, the zlib error otherwise.
+     */
+    int decode(const char *data, const size_t size)
     {
-        ssl = SSL_new(m_State->ssl);
-        SSL_set_fd(ssl, sock);
+        stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+        stream.avail_in = static_cast<uInt>(size);
+
+        // keep going while there is input, or the last round filled the buffer and more output may be pending
+        do
+        {
+            if (finished && stream.avail_in)
+            {
+                if (const auto status = inflateReset(&stream); status != Z_OK)
+                {
+                    return status;
+                }
+
+                finished = false;
+            }
+
+            char chunk[16384];
+
+            stream.next_out = reinterpret_cast<Bytef *>(chunk);
+            stream.avail_out = sizeof(chunk);
+
+            const auto status = inflate(&stream, Z_NO_FLUSH);
+            if (status == Z_BUF_ERROR)
+            {
+                break;
+            }
 
-        SSL_set_tlsext_host_name(ssl, request.Location.Host.c_str());
-        SSL_set1_host(ssl, request.Location.Host.c_str());
-        SSL_set_verify(ssl, SSL_VERIFY_PEER, nullptr);
+            if (status != Z_OK && status != Z_STREAM_END)
+            {
+                return status;
+            }
+
+            target.write(chunk, static_cast<std::streamsize>(sizeof(chunk) - stream.avail_out));
+            if (!target)
+            {
+                return Z_ERRNO;
+            }
+
+            finished = status == Z_STREAM_END;
+        }
+        while (stream.avail_in || !stream.avail_out);
+
+        return Z_OK;
+    }
+
+    std::ostream &target;
+    z_stream stream{};
+    bool ready{};
+    bool finished{};
+    bool detecting = true;
+    std::string head;
+};
+
+[[nodiscard]] static toolkit::result<> read_fixed_body(HttpConnection &connection, size_t length, std::ostream *body)
+{
+    char chunk[16384];
 
-        if (auto result = SSL_connect(ssl); result <= 0)
+    while (length)
+    {
+        const auto len = connection.read({ chunk, std::min(length, sizeof(chunk)) });
+        if (len <= 0)
         {
-            return toolkit::make_error("TLS handshake failed.");
+            return toolkit::make_error("connection closed before the end of the body.");
         }
 
-        if (SSL_get_verify_result(ssl) != X509_V_OK)
+        if (body)
         {
-            return toolkit::make_error("TLS certificate verification failed.");
+            body->write(chunk, len);
         }
 
-        transport = std::make_unique<HttpTlsTransport>(ssl);
+        length -= len;
     }
-    else
+
+    return {};
+}
+
+/**
+ * Read a body with chunked transfer encoding, writing only the chunk data. Extensions and trailers are skipped.
+ */
+[[nodiscard]] static toolkit::result<> read_chunked_body(HttpConnection &connection, std::ostream *body)
+{
+    std::string line;
+
+    for (;;)
+    {
+        if (auto res = connection.read_until(line, unvm::http::EOL); !res)
+        {
+            return toolkit::make_error("failed to read chunk size: {}", res.error());
+        }
+
+        size_t size;
+        const auto end = line.data() + std::min(line.find(';'), line.size());
+        if (auto [ptr, ec] = std::from_chars(line.data(), end, size, 16); ec != std::errc() || ptr == line.data())
+        {
+            return toolkit::make_error("invalid chunk size '{}'.", line);
+        }
+
+        if (!size)
+        {
+            break;
+        }
+
+        if (auto res = read_fixed_body(connection, size, body); !res)
+        {
+            return res;
+        }
+
+        if (auto res = connection.read_until(line, unvm::http::EOL); !res || !line.empty())
+        {
+            return toolkit::make_error("missing chunk delimiter.");
+        }
+    }
+
+    do
+    {
+        if (auto res = connection.read_until(line, unvm::http::EOL); !res)
+        {
+            return toolkit::make_error("failed to read trailer: {}", res.error());
+        }
+    }
+    while (!line.empty());
+
+    return {};
+}
+
+static void read_remaining_body(HttpConnection &connection, std::ostream *body)
+{
+    char chunk[16384];
+
+    for (;;)
+    {
+        const auto len = connection.read(chunk);
+        if (len <= 0)
+        {
+            break;
+        }
+
+        if (body)
+        {
+            body->write(chunk, len);
+        }
+    }
+}
+
+[[nodiscard]] static bool has_token(const unvm::http::HttpHeaders &headers, const std::string &key, const char *token)
+{
+    const auto it = headers.find(key);
+    return it != headers.end() && toolkit::lowercase(it->second).find(token) != std::string::npos;
+}
+
+toolkit::result<> unvm::http::HttpClient::Fetch(HttpRequest request, HttpResponse &response) const
+{
+    TraceSpan span("HttpClient::Fetch");
+
+    if (request.Location.Scheme != "http" && request.Location.Scheme != "https")
     {
-        transport = std::make_unique<HttpTcpTransport>(sock);
+        return toolkit::make_error("unsupported scheme '{}'", request.Location.Scheme);
+    }
+
+    if (request.Location.Scheme == "https")
+    {
+        if (auto res = InitTLS(); !res)
+        {
+            return res;
+        }
     }
 
     set_header_if_missing(request.Headers, "Host", request.Location.Host);
-    set_header_if_missing(request.Headers, "Connection", "close");
-    set_header_if_missing(request.Headers, "Accept-Encoding", "identity");
+    set_header_if_missing(request.Headers, "Connection", "keep-alive");
+    set_header_if_missing(request.Headers, "Accept-Encoding", "gzip, deflate");
     set_header_if_missing(request.Headers, "User-Agent", "unvm/0.1");
 
     std::stringstream packet;
@@ -360,47 +930,115 @@ toolkit::result<> unvm::http::HttpClient::Fetch(HttpRequest request, HttpRespons
     }
     packet << EOL;
 
-    if (transport->write(packet.str()) < 0)
-    {
-        return toolkit::make_error("failed to send header.");
-    }
+    const auto header = packet.str();
 
-    char chunk[4096];
+    const auto key = std::format(
+        "{}://{}:{}",
+        request.Location.Scheme,
+        request.Location.Host,
+        request.Location.Port);
 
-    if (request.Body)
+    std::unique_ptr<HttpConnection> connection;
+    std::string header_block;
+
+    // an idle connection may have been closed by the server in the meantime, which only shows once it is used. a
+    // request without body can simply be sent again, on the next idle or on a fresh connection.
+    for (;;)
     {
-        size_t count = 0;
+        SSL_SESSION *session{};
 
-        while (true)
         {
-            request.Body->read(chunk, sizeof(chunk));
-            const size_t len = request.Body->gcount();
+            std::lock_guard lock(m_State->mutex);
 
-            if (len <= 0)
+            if (auto &idle = m_State->idle[key]; !idle.empty())
             {
-                break;
+                connection = std::move(idle.back());
+                idle.pop_back();
+            }
+            else if ((session = m_State->sessions[key]))
+            {
+                SSL_SESSION_up_ref(session);
+            }
+        }
+
+        const auto reused = !!connection;
+
+        if (reused)
+        {
+            if (!connection->is_idle())
+            {
+                connection.reset();
+                continue;
             }
+        }
+        else
+        {
+            auto res = open_connection(request.Location, m_State->ssl, session) >> connection;
 
-            if (transport->write({ chunk, len }) < 0)
+            if (session)
             {
-                return toolkit::make_error("failed to send chunk.");
+                SSL_SESSION_free(session);
             }
 
-            count += len;
+            if (!res)
+            {
+                return res;
+            }
         }
-    }
 
-    std::string header_block;
-    if (auto res = read_until(transport.get(), header_block, EOL2); !res)
-    {
-        return toolkit::make_error("failed to read header block: {}", res.error());
+        auto res = [&]() -> toolkit::result<>
+        {
+            if (connection->transport->write(header) < 0)
+            {
+                return toolkit::make_error("failed to send header.");
+            }
+
+            char chunk[4096];
+
+            if (request.Body)
+            {
+                while (true)
+                {
+                    request.Body->read(chunk, sizeof(chunk));
+                    const size_t len = request.Body->gcount();
+
+                    if (len <= 0)
+                    {
+                        break;
+                    }
+
+                    if (connection->transport->write({ chunk, len }) < 0)
+                    {
+                        return toolkit::make_error("failed to send chunk.");
+                    }
+                }
+            }
+
+            if (auto read_res = connection->read_until(header_block, EOL2); !read_res)
+            {
+                return toolkit::make_error("failed to read header block: {}", read_res.error());
+            }
+
+            return {};
+        }();
+
+        if (res)
+        {
+            break;
+        }
+
+        if (!reused || request.Body)
+        {
+            return res;
+        }
+
+        connection.reset();
     }
 
-    auto headers_end = header_block.find(EOL2);
-    auto headers = header_block.substr(0, headers_end);
-    auto body_prefetch = header_block.substr(headers_end + 4);
+    // the delimiter consumed the end of the last header line, which ParseHeaders still expects
+    header_block += EOL;
 
-    std::istringstream headers_stream(headers);
+    std::istringstream headers_stream(header_block);
 
     std::string status_line;
     GetLine(headers_stream, status_line, EOL);
@@ -413,40 +1051,140 @@ toolkit::result<> unvm::http::HttpClient::Fetch(HttpRequest request, HttpRespons
 
     ParseHeaders(headers_stream, response.Headers);
 
-    auto content_length = ~size_t();
-    if (auto it = response.Headers.find("content-length"); it != response.Headers.end())
+    auto reusable = !has_token(response.Headers, "connection", "close");
+
+    const auto has_body = request.Method != HttpMethod::Head
+                          && !IsDirective(response.StatusCode)
+                          && response.StatusCode != HttpStatusCode::NoContent
+                          && response.StatusCode != HttpStatusCode::NotModified;
+
+    auto body = response.Body;
+
+    std::optional<InflateBuffer> inflater;
+    std::optional<std::ostream> decoded;
+
+    if (auto it = response.Headers.find("content-encoding"); has_body && body && it != response.Headers.end())
     {
+        if (const auto encoding = toolkit::lowercase(it->second);
+            encoding == "gzip" || encoding == "x-gzip" || encoding == "deflate")
+        {
+            inflater.emplace(*body);
+            if (!inflater->ready)
+            {
+                return toolkit::make_error("failed to initialize zlib.");
+            }
+
+            decoded.emplace(&*inflater);
+            body = &*decoded;
+        }
+        else if (encoding != "identity")
+        {
+            return toolkit::make_error("unsupported content encoding '{}'.", it->second);
+        }
+    }
+
+    if (!has_body)
+    {
+    }
+    else if (has_token(response.Headers, "transfer-encoding", "chunked"))
+    {
+        if (auto res = read_chunked_body(*connection, body); !res)
+        {
+            return res;
+        }
+    }
+    else if (auto it = response.Headers.find("content-length"); it != response.Headers.end())
+    {
+        size_t content_length;
         if (auto res = ParseString<size_t>(it->second) >> content_length; !res)
         {
             return res;
         }
+
+        if (auto res = read_fixed_body(*connection, content_length, body); !res)
+        {
+            return res;
+        }
+    }
+    else
+    {
+        // without any framing, the body ends with the connection
+        read_remaining_body(*connection, body);
+        reusable = false;
     }
 
-    if (response.Body)
+    if (inflater && (!*decoded || !inflater->finished))
     {
-        response.Body->write(body_prefetch.data(), static_cast<long>(body_prefetch.size()));
+        return toolkit::make_error(
+            "failed to decode body with content encoding '{}'.",
+            response.Headers["content-encoding"]);
     }
 
-    auto count = body_prefetch.size();
-    while (content_length == ~size_t() || count < content_length)
+    SSL_SESSION *stored{};
+
     {
-        auto len = transport->read(chunk);
-        if (len <= 0)
+        std::lock_guard lock(m_State->mutex);
+
+        // a resumed session is already stored, only the result of a full handshake is worth writing to disk
+        if (connection->ssl && !SSL_session_reused(connection->ssl))
         {
-            break;
+            if (const auto current = SSL_get1_session(connection->ssl); current && SSL_SESSION_is_resumable(current))
+            {
+                auto &session = m_State->sessions[key];
+                if (session)
+                {
+                    SSL_SESSION_free(session);
+                }
+
+                session = current;
+
+                SSL_SESSION_up_ref(current);
+                stored = current;
+            }
+            else if (current)
+            {
+                SSL_SESSION_free(current);
+            }
         }
 
-        if (response.Body)
+        // anything left over would be mistaken for the start of the next response
+        if (auto &idle = m_State->idle[key]; reusable && connection->pending.empty() && idle.size() < State::MaxIdle)
         {
-            response.Body->write(chunk, len);
+            idle.push_back(std::move(connection));
         }
+    }
 
-        count += len;
+    // written without the lock, so no other request waits for the file. the cache only saves handshakes, failing to
+    // update it does not fail the request
+    if (stored)
+    {
+        {
+            std::lock_guard lock(m_State->store_mutex);
+            (void) store_session(key, stored);
+        }
+
+        SSL_SESSION_free(stored);
     }
 
     return {};
 }
 
+void unvm::http::ApplyLocation(URL &url, const std::string &location)
+{
+    if (location.find("://") != std::string::npos)
+    {
+        url = ParseURL(location);
+    }
+    else if (location.starts_with("/"))
+    {
+        url.Pathname = location;
+    }
+    else
+    {
+        url.Pathname += location;
+    }
+}
+
 toolkit::result<> unvm::http::HttpClient::FetchWithRedirects(HttpRequest request, HttpResponse &response) const
 {
     bool is_redirect;
@@ -458,7 +1196,8 @@ toolkit::result<> unvm::http::HttpClient::FetchWithRedirects(HttpRequest request
             return res;
         }
 
-        is_redirect = IsRedirect(response.StatusCode);
+        // a 304 answers a conditional request and has nothing to follow
+        is_redirect = IsRedirect(response.StatusCode) && response.StatusCode != HttpStatusCode::NotModified;
 
         if (!is_redirect)
         {
@@ -475,18 +1214,7 @@ toolkit::result<> unvm::http::HttpClient::FetchWithRedirects(HttpRequest request
 
         const auto &location = it->second;
 
-        if (location.find("://") != std::string::npos)
-        {
-            request.Location = ParseURL(location);
-        }
-        else if (location.starts_with("/"))
-        {
-            request.Location.Pathname = location;
-        }
-        else
-        {
-            request.Location.Pathname += location;
-        }
+        ApplyLocation(request.Location, location);
 
         std::cerr << "redirect to " << location << " --> " << request.Location << std::endl;
     }
@@ -13,6 +13,16 @@
 #include <iostream>
 #include <sstream>
 
+static unvm::http::URL get_repo_location(const std::string &version, const std::string &filename)
+{
+    return {
+        .Scheme = "https",
+        .Host = "nodejs.org",
+        .Port = 443,
+        .Pathname = std::format("/dist/{}/{}", version, filename),
+    };
+}
+
 [[nodiscard]] static toolkit::result<bool> get_file_from_repo(
     unvm::http::HttpClient &client,
     std::ostream &stream,
@@ -23,12 +33,7 @@
     unvm::http::HttpRequest request
     {
         .Method = unvm::http::HttpMethod::Get,
-        .Location = {
-            .Scheme = "https",
-            .Host = "nodejs.org",
-            .Port = 443,
-            .Pathname = std::format("/dist/{}/{}", version, filename),
-        },
+        .Location = get_repo_location(version, filename),
     };
 
     unvm::http::HttpResponse response
@@ -63,10 +68,42 @@
     return true;
 }
 
+/**
+ * Download an archive straight to disk, over several connections if the server allows.
+ */
+[[nodiscard]] static toolkit::result<> get_archive_from_repo(
+    const unvm::http::HttpClient &client,
+    const std::filesystem::path &path,
+    const std::string &version,
+    const std::string &filename)
+{
+    unvm::http::HttpResponse response;
+    if (auto res = unvm::http::Download(client, get_repo_location(version, filename), path, response); !res)
+    {
+        return toolkit::make_error(
+            "failed to get file {} (version {}) from repo: {}",
+            filename,
+            version,
+            res.error());
+    }
+
+    if (!unvm::http::IsSuccess(response.StatusCode))
+    {
+        return toolkit::make_error(
+            "failed to get file {} (version {}) from repo: {}, {}",
+            filename,
+            version,
+            response.StatusCode,
+            response.StatusMessage);
+    }
+
+    return {};
+}
+
 [[nodiscard]] static toolkit::result<std::string> get_trusted_checksum(
     unvm::Config &config,
     unvm::http::HttpClient &client,
-    const unvm::VersionEntry &entry,
+    const std::string &version,
     const std::string &with_extension)
 {
     constexpr auto flags = std::stringstream::in | std::stringstream::out | std::stringstream::binary;
@@ -75,7 +112,7 @@
     if (auto res = get_file_from_repo(
         client,
         stream,
-        entry.Version,
+        version,
         "SHASUMS256.txt",
         false
     ); !res)
@@ -88,7 +125,7 @@
     if (auto res = get_file_from_repo(
                        client,
                        signature_stream,
-                       entry.Version,
+                       version,
                        "SHASUMS256.txt.sig",
                        true
                    ) >> has_signature; !res)
@@ -155,11 +192,11 @@
     }
     else
     {
-        std::cout << "version '" << entry.Version << "' does not have a signature file." << std::endl;
+        std::cout << "version '" << version << "' does not have a signature file." << std::endl;
 
         if (auto trust = unvm::Confirm("install anyways?"); !trust)
         {
-            return toolkit::make_error("version '{}' does not have a signature file.", entry.Version);
+            return toolkit::make_error("version '{}' does not have a signature file.", version);
         }
     }
 
@@ -225,11 +262,15 @@
 
 toolkit::result<> unvm::Install(
     Config &config,
-    http::HttpClient &client,
+    ResolutionContext &resolution,
     std::string_view version,
     const VersionEntry &entry)
 {
-    if (config.Installed.contains(entry.Version))
+    auto &client = resolution.Client();
+
+    const std::string entry_version(entry.Version());
+
+    if (config.Installed.contains(entry_version))
     {
         std::cerr << "version '" << version << "' is already installed." << std::endl;
         return {};
@@ -237,11 +278,11 @@ toolkit::result<> unvm::Install(
 
     auto [format, extension, pattern] = platform;
 
-    auto filename = std::format(format, entry.Version);
+    auto filename = std::format(format, entry_version);
     auto with_extension = std::format("{}.{}", filename, extension);
 
     std::string trusted_checksum;
-    if (auto res = get_trusted_checksum(config, client, entry, with_extension) >> trusted_checksum; !res)
+    if (auto res = get_trusted_checksum(config, client, entry_version, with_extension) >> trusted_checksum; !res)
     {
         return toolkit::make_error("failed to get trusted checksum: {}", res.error());
     }
@@ -268,12 +309,9 @@ toolkit::result<> unvm::Install(
         archive_name);
 
     // write archive to disk
+    if (auto res = get_archive_from_repo(client, archive_name, entry_version, with_extension); !res)
     {
-        std::ofstream archive_stream(archive_name, std::ios::binary);
-        if (auto res = get_file_from_repo(client, archive_stream, entry.Version, with_extension, false); !res)
-        {
-            return toolkit::make_error("failed to get archive: {}", res.error());
-        }
+        return toolkit::make_error("failed to get archive: {}", res.error());
     }
 
     // read archive from disk, get file checksum
@@ -315,7 +353,7 @@ toolkit::result<> unvm::Install(
     }
 
     auto from_path = data_directory / filename;
-    auto to_path = data_directory / entry.Version;
+    auto to_path = data_directory / entry_version;
 
     if (std::error_code ec; std::filesystem::rename(from_path, to_path, ec), ec)
     {
@@ -327,23 +365,22 @@ toolkit::result<> unvm::Install(
             ec.value());
     }
 
-    config.Installed.insert(entry.Version);
-    config.AddedVersions.insert(entry.Version);
+    config.Installed.insert(entry_version);
+    config.AddedVersions.insert(entry_version);
+
+    resolution.Invalidate();
     return {};
 }
 
-toolkit::result<> unvm::Install(Config &config, http::HttpClient &client, const std::string_view version)
+toolkit::result<> unvm::Install(Config &config, ResolutionContext &resolution, const std::string_view version)
 {
-    VersionTable table;
-    if (auto res = LoadVersionTable(client, table, true); !res)
+    if (auto res = resolution.Table(true, false); !res)
     {
         return toolkit::make_error("failed to load version table: {}", res.error());
     }
 
-    FilterVersionTable(config, table, true);
-
-    const VersionEntry *entry{};
-    if (auto res = FindVersionEntry(table, version) >> entry; !res)
+    VersionEntry entry;
+    if (auto res = resolution.Find(version, true, false) >> entry; !res)
     {
         return res;
     }
@@ -354,7 +391,7 @@ toolkit::result<> unvm::Install(Config &config, http::HttpClient &client, const
     }
 
     const auto data_directory = GetDataDirectory();
-    const auto lock_path = data_directory / (entry->Version + ".lock");
+    const auto lock_path = data_directory / (std::string(entry.Version()) + ".lock");
 
     TryAcquire lock(lock_path, false, "install");
     if (!lock)
@@ -371,9 +408,11 @@ toolkit::result<> unvm::Install(Config &config, http::HttpClient &client, const
         {
             return res;
         }
+
+        resolution.Invalidate();
     }
 
     (void) lock;
 
-    return Install(config, client, version, *entry);
+    return Install(config, resolution, version, entry);
 }
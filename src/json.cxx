@@ -43,7 +43,7 @@ void data::serializer<unvm::Config>::to_data(json::Node &node, const unvm::Confi
     };
 }
 
-bool data::serializer<unvm::VersionEntry>::from_data(const json::Node &node, unvm::VersionEntry &value)
+bool data::serializer<unvm::VersionInfo>::from_data(const json::Node &node, unvm::VersionInfo &value)
 {
     if (!node.Is<json::Node::Map>())
     {
@@ -3,37 +3,55 @@
 
 #include <toolkit/string.hxx>
 
+#include <format>
 #include <iostream>
 #include <ranges>
 
+/**
+ * Format a yyyymmdd date back into the 'yyyy-mm-dd' form of index.json.
+ */
+static std::string format_date(const uint32_t date)
+{
+    if (!date)
+    {
+        return {};
+    }
+
+    return std::format("{:04}-{:02}-{:02}", date / 10000, date / 100 % 100, date % 100);
+}
+
+static std::string optional_string(const std::optional<std::string_view> &value)
+{
+    return value ? std::string(*value) : std::string();
+}
+
 toolkit::result<> unvm::List(
     const Config &config,
-    http::HttpClient &client,
+    ResolutionContext &resolution,
     const bool available,
     const bool flat,
     const bool details)
 {
-    VersionTable table;
-    if (auto res = LoadVersionTable(client, table, available); !res)
+    const VersionView *view;
+    if (auto res = resolution.Table(available, !available) >> view; !res)
     {
         return res;
     }
 
-    FilterVersionTable(config, table, true, !available);
-
     if (flat)
     {
         std::unordered_set<std::string> versions;
 
-        for (auto &entry : table)
+        for (const auto entry : *view)
         {
-            versions.insert(entry.Version);
-            versions.insert(entry.Version.substr(1));
+            const auto version = entry.Version();
+            versions.emplace(version);
+            versions.emplace(version.substr(1));
 
-            if (entry.LTS)
+            if (const auto lts = entry.LTS())
             {
-                versions.insert(*entry.LTS);
-                versions.insert(toolkit::lowercase(*entry.LTS));
+                versions.emplace(*lts);
+                versions.insert(toolkit::lowercase(std::string(*lts)));
             }
         }
 
@@ -64,20 +82,22 @@ toolkit::result<> unvm::List(
                 { "Modules", false },
             });
 
-        for (auto &entry : table)
+        for (const auto entry : *view)
         {
+            const std::string version(entry.Version());
+
             out
-                    << (config.Active == entry.Version ? "yes" : "")
-                    << (entry.Security ? "yes" : "")
-                    << entry.LTS.value_or(std::string())
-                    << entry.Version
-                    << entry.NPM.value_or(std::string())
-                    << entry.V8
-                    << entry.UV.value_or(std::string())
-                    << entry.ZLib.value_or(std::string())
-                    << entry.OpenSSL.value_or(std::string())
-                    << entry.Date
-                    << std::to_string(entry.Modules);
+                    << (config.Active == version ? "yes" : "")
+                    << (entry.Security() ? "yes" : "")
+                    << optional_string(entry.LTS())
+                    << version
+                    << optional_string(entry.NPM())
+                    << std::string(entry.V8())
+                    << optional_string(entry.UV())
+                    << optional_string(entry.ZLib())
+                    << optional_string(entry.OpenSSL())
+                    << format_date(entry.Date())
+                    << std::to_string(entry.Modules());
         }
     }
     else
@@ -93,9 +113,11 @@ toolkit::result<> unvm::List(
 
         std::unordered_set<std::string> major_versions;
 
-        for (auto &entry : table)
+        for (const auto entry : *view)
         {
-            auto segments = toolkit::split(entry.Version, '.');
+            const std::string version(entry.Version());
+
+            auto segments = toolkit::split(version, '.');
             if (available && major_versions.contains(segments.front()))
             {
                 continue;
@@ -104,11 +126,11 @@ toolkit::result<> unvm::List(
             major_versions.insert(segments.front());
 
             out
-                    << (config.Active == entry.Version ? "*" : "")
-                    << entry.LTS.value_or(std::string())
-                    << entry.Version
-                    << entry.NPM.value_or(std::string())
-                    << entry.Date;
+                    << (config.Active == version ? "*" : "")
+                    << optional_string(entry.LTS())
+                    << version
+                    << optional_string(entry.NPM())
+                    << format_date(entry.Date());
         }
     }
 
@@ -1,14 +1,313 @@
+#include <unvm/index.hxx>
 #include <unvm/json.hxx>
 #include <unvm/lock.hxx>
+#include <unvm/trace.hxx>
 #include <unvm/unvm.hxx>
 #include <unvm/util.hxx>
 #include <unvm/http/url.hxx>
 
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdlib>
 #include <fstream>
+#include <iostream>
 #include <sstream>
 
+#if defined(SYSTEM_WINDOWS)
+
+#include <process.h>
+
+#define getpid _getpid
+
+#else
+
+#include <unistd.h>
+
+#endif
+
+static void write_version_index(
+    const std::filesystem::path &path,
+    const unvm::VersionIndex::SourceStamp &source,
+    const unvm::VersionTable &table)
+{
+    if (auto res = unvm::VersionIndex::Write(path, source, table); !res)
+    {
+        std::cerr << "warning: failed to write version index: " << res.error() << std::endl;
+    }
+}
+
+/**
+ * Build the table from the parsed index.json, sorted newest first, with entries that could not be packed last. Range
+ * lookups rely on this order to binary search the table.
+ */
+[[nodiscard]] static bool read_version_table(const json::Node &node, unvm::VersionTable &table)
+{
+    std::vector<unvm::VersionInfo> infos;
+    if (!(node >> infos))
+    {
+        return false;
+    }
+
+    table.Clear();
+    table.Reserve(infos.size());
+
+    for (auto &info : infos)
+    {
+        table.Append(info);
+    }
+
+    table.Sort();
+    return true;
+}
+
+/**
+ * How long a copy of index.json is used before asking for a newer one, one hour unless the UNVM_INDEX_MAX_AGE
+ * environment variable sets a number of seconds.
+ */
+[[nodiscard]] static std::chrono::seconds get_max_age()
+{
+    constexpr auto fallback = std::chrono::seconds(std::chrono::hours(1));
+
+    const auto variable = std::getenv("UNVM_INDEX_MAX_AGE");
+    if (!variable)
+    {
+        return fallback;
+    }
+
+    const std::string_view value(variable);
+
+    int64_t seconds;
+    if (auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), seconds);
+        ec != std::errc() || ptr != value.data() + value.size() || seconds < 0)
+    {
+        return fallback;
+    }
+
+    return std::chrono::seconds(seconds);
+}
+
+/**
+ * Check if index.json has to be downloaded, either because there is no copy yet, or, if online, because the copy was
+ * last checked longer ago than the max age. The last check is the time the validators were written, or of the copy
+ * itself if there are none.
+ */
+[[nodiscard]] static bool needs_refresh(
+    const std::filesystem::path &index_path,
+    const std::filesystem::path &meta_path,
+    const bool online)
+{
+    std::error_code ec;
+    auto last_check = std::filesystem::last_write_time(index_path, ec);
+    if (ec)
+    {
+        return true;
+    }
+
+    if (!online)
+    {
+        return false;
+    }
+
+    if (const auto meta_write = std::filesystem::last_write_time(meta_path, ec); !ec)
+    {
+        last_check = std::max(last_check, meta_write);
+    }
+
+    return std::filesystem::file_time_type::clock::now() - last_check > get_max_age();
+}
+
+static constexpr const char *validator_names[]{ "etag", "last-modified" };
+
+/**
+ * Read the ETag and Last-Modified headers stored with the last copy of index.json, one "<name>\t<value>" line each.
+ */
+[[nodiscard]] static unvm::http::HttpHeaders read_validators(const std::filesystem::path &path)
+{
+    unvm::http::HttpHeaders validators;
+
+    std::ifstream stream(path);
+
+    std::string line;
+    while (std::getline(stream, line))
+    {
+        if (const auto tab = line.find('\t'); tab != std::string::npos)
+        {
+            validators[line.substr(0, tab)] = line.substr(tab + 1);
+        }
+    }
+
+    return validators;
+}
+
+/**
+ * Store the validators of a response, replacing the file by rename. Also marks the time of the last check, so it is
+ * rewritten after a 304 as well.
+ */
+[[nodiscard]] static toolkit::result<> write_validators(
+    const std::filesystem::path &path,
+    const unvm::http::HttpHeaders &headers)
+{
+    auto temp_path = path;
+    temp_path += std::format(".{}", getpid());
+
+    {
+        std::ofstream stream(temp_path, std::ios::trunc);
+
+        for (auto name : validator_names)
+        {
+            if (auto it = headers.find(name); it != headers.end())
+            {
+                stream << name << '\t' << it->second << '\n';
+            }
+        }
+
+        if (!stream)
+        {
+            return toolkit::make_error("failed to write '{}'.", temp_path.string());
+        }
+    }
+
+    if (std::error_code ec; unvm::RenameFile(temp_path, path, ec), ec)
+    {
+        std::error_code remove_ec;
+        std::filesystem::remove(temp_path, remove_ec);
+
+        return toolkit::make_error("failed to rename '{}': {} ({}).", path.string(), ec.message(), ec.value());
+    }
+
+    return {};
+}
+
+/**
+ * Download index.json and build the table from it. The new copy is written to a temp file of this process and then
+ * renamed over the old one, so concurrent readers see either the old or the new copy, never a partial one.
+ *
+ * If there is a copy already, the request is conditional on the validators stored with it. Results in false if the
+ * server answered that it did not change, in which case only the time of the last check is updated, and the table is
+ * left for the caller to read from the existing files.
+ */
+[[nodiscard]] static toolkit::result<bool> refresh_version_table(
+    unvm::http::HttpClient &client,
+    const std::filesystem::path &index_path,
+    const std::filesystem::path &binary_path,
+    const std::filesystem::path &meta_path,
+    unvm::VersionTable &table)
+{
+    std::stringstream stream;
+
+    unvm::http::HttpRequest request
+    {
+        .Method = unvm::http::HttpMethod::Get,
+        .Location = unvm::http::ParseURL("https://nodejs.org/dist/index.json"),
+    };
+    unvm::http::HttpResponse response
+    {
+        .Body = &stream,
+    };
+
+    // validators without a copy to fall back on would only get a 304 that is of no use
+    unvm::http::HttpHeaders validators;
+    if (std::filesystem::exists(index_path))
+    {
+        validators = read_validators(meta_path);
+    }
+
+    if (auto it = validators.find("etag"); it != validators.end())
+    {
+        request.Headers["If-None-Match"] = it->second;
+    }
+
+    if (auto it = validators.find("last-modified"); it != validators.end())
+    {
+        request.Headers["If-Modified-Since"] = it->second;
+    }
+
+    if (auto res = client.FetchWithRedirects(std::move(request), response); !res)
+    {
+        return toolkit::make_error("failed to get file: {}", res.error());
+    }
+
+    if (response.StatusCode == unvm::http::HttpStatusCode::NotModified)
+    {
+        // a 304 may carry updated validators, the stored ones stay valid otherwise
+        for (auto name : validator_names)
+        {
+            if (auto it = response.Headers.find(name); it != response.Headers.end())
+            {
+                validators[name] = it->second;
+            }
+        }
+
+        // the copy is still good, but without the new check time the next process asks again
+        if (auto res = write_validators(meta_path, validators); !res)
+        {
+            std::cerr << "warning: failed to store validators of version table: " << res.error() << std::endl;
+        }
+
+        return false;
+    }
+
+    if (!unvm::http::IsSuccess(response.StatusCode))
+    {
+        return toolkit::make_error(
+            "failed to get file: {}, {}\n{}",
+            response.StatusCode,
+            response.StatusMessage,
+            stream.str());
+    }
+
+    json::Node node;
+    stream >> node;
+
+    if (!read_version_table(node, table))
+    {
+        return toolkit::make_error("failed to parse table json.");
+    }
+
+    auto temp_path = index_path;
+    temp_path += std::format(".{}", getpid());
+
+    {
+        std::ofstream file(temp_path, std::ios::trunc);
+        file << node;
+
+        if (!file)
+        {
+            return toolkit::make_error("failed to write '{}'.", temp_path.string());
+        }
+    }
+
+    // the rename keeps size and modification time, so the stamp of the temp file is the one of the published copy
+    unvm::VersionIndex::SourceStamp source;
+    const auto stamped = unvm::VersionIndex::GetSourceStamp(temp_path, source);
+
+    if (std::error_code ec; unvm::RenameFile(temp_path, index_path, ec), ec)
+    {
+        std::error_code remove_ec;
+        std::filesystem::remove(temp_path, remove_ec);
+
+        return toolkit::make_error("failed to rename version table: {} ({}).", ec.message(), ec.value());
+    }
+
+    // written after the copy, so validators never describe a newer copy than the one on disk
+    if (auto res = write_validators(meta_path, response.Headers); !res)
+    {
+        std::cerr << "warning: failed to store validators of version table: " << res.error() << std::endl;
+    }
+
+    if (stamped)
+    {
+        write_version_index(binary_path, source, table);
+    }
+
+    return true;
+}
+
 toolkit::result<> unvm::LoadVersionTable(http::HttpClient &client, VersionTable &table, bool online)
 {
+    TraceSpan span("LoadVersionTable");
+
     /**
      * {
      *   version:  string
@@ -25,7 +324,7 @@ toolkit::result<> unvm::LoadVersionTable(http::HttpClient &client, VersionTable
      * }[]
      */
 
-    table.clear();
+    table.Clear();
 
     auto data_directory = GetDataDirectory();
 
@@ -35,96 +334,90 @@ toolkit::result<> unvm::LoadVersionTable(http::HttpClient &client, VersionTable
     }
 
     auto index_path = data_directory / "index.json";
+    auto binary_path = data_directory / "index.bin";
     auto lock_path = data_directory / "index.lock";
+    auto meta_path = data_directory / "index.meta";
 
-    FileLock lock;
-    if (auto res = FileLock::Lock(lock_path) >> lock; !res)
-    {
-        return res;
-    }
-
-    bool is_stale{};
-    if (online && std::filesystem::exists(index_path))
-    {
-        constexpr auto stale = std::chrono::hours(1);
-
-        auto last_write = std::filesystem::last_write_time(index_path);
-        auto now = std::filesystem::file_time_type::clock::now();
-
-        is_stale = now - last_write > stale;
-    }
-
-    if ((online && is_stale) || !std::filesystem::exists(index_path))
+    // both files are only ever replaced by rename, so reading them needs no lock. the lock only makes sure that one
+    // process downloads at a time, and nobody waits for it as long as there is any copy of the index to read.
+    if (needs_refresh(index_path, meta_path, online))
     {
-        std::stringstream stream;
-
-        http::HttpRequest request
-        {
-            .Method = http::HttpMethod::Get,
-            .Location = http::ParseURL("https://nodejs.org/dist/index.json"),
-        };
-        http::HttpResponse response
-        {
-            .Body = &stream,
-        };
+        const auto missing = !std::filesystem::exists(index_path);
 
-        if (auto res = client.FetchWithRedirects(std::move(request), response); !res)
+        FileLock lock;
+        if (auto res = (missing ? FileLock::Lock(lock_path) : FileLock::TryLock(lock_path)) >> lock; !res)
         {
-            return toolkit::make_error("failed to get file: {}", res.error());
+            return res;
         }
 
-        if (!IsSuccess(response.StatusCode))
+        // someone else may have published a fresh copy while this process was waiting
+        if (lock && needs_refresh(index_path, meta_path, online))
         {
-            return toolkit::make_error(
-                "failed to get file: {}, {}\n{}",
-                response.StatusCode,
-                response.StatusMessage,
-                stream.str());
-        }
+            bool refreshed;
+            if (auto res = refresh_version_table(client, index_path, binary_path, meta_path, table) >> refreshed; !res)
+            {
+                return res;
+            }
 
-        json::Node node;
-        stream >> node;
-
-        if (!(node >> table))
-        {
-            return toolkit::make_error("failed to parse table json.");
+            if (refreshed)
+            {
+                return {};
+            }
         }
+    }
 
-        std::ofstream file(index_path);
-        file << node;
-
+    if (VersionIndex index; VersionIndex::Open(binary_path, index_path) >> index && std::move(index).Read(table))
+    {
         return {};
     }
 
+    // a refresher may rename a new copy over the file while it is being read, in which case the stamp taken after
+    // reading no longer describes the parsed rows, and the binary index is left for the next reader to write
+    VersionIndex::SourceStamp before;
+    const auto stamped = VersionIndex::GetSourceStamp(index_path, before);
+
     std::ifstream stream(index_path);
 
     json::Node node;
     stream >> node;
 
-    if (!(node >> table))
+    if (!read_version_table(node, table))
     {
         return toolkit::make_error("failed to parse table json.");
     }
 
+    if (VersionIndex::SourceStamp after; stamped && VersionIndex::GetSourceStamp(index_path, after) && after == before)
+    {
+        write_version_index(binary_path, before, table);
+    }
+
     return {};
 }
 
-void unvm::FilterVersionTable(const Config &config, VersionTable &table, const bool supported, const bool installed)
+unvm::VersionView unvm::FilterVersionTable(
+    const Config &config,
+    const VersionView &view,
+    const bool supported,
+    const bool installed)
 {
-    const std::string pattern(platform.Pattern);
+    constexpr auto mask = GetPlatformFileMask(platform.Pattern);
 
-    for (auto it = table.begin(); it != table.end();)
-    {
-        const auto is_supported = it->Files.contains(pattern);
-        const auto is_installed = config.Installed.contains(it->Version);
+    std::string version;
 
-        if ((supported && !is_supported) || (installed && !is_installed))
-        {
-            it = table.erase(it);
-        }
-        else
+    return view.Filter(
+        [&](const VersionEntry &entry)
         {
-            ++it;
-        }
-    }
+            if (supported && !(entry.Files() & mask))
+            {
+                return false;
+            }
+
+            if (installed)
+            {
+                version.assign(entry.Version());
+                return config.Installed.contains(version);
+            }
+
+            return true;
+        });
 }
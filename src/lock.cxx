@@ -1,23 +1,41 @@
-#include <fstream>
 #include <unvm/lock.hxx>
+#include <unvm/trace.hxx>
 
-#include <thread>
+#include <format>
+#include <fstream>
 
 #if defined(SYSTEM_WINDOWS)
 
 #define NOMINMAX
 
+#include <process.h>
 #include <windows.h>
 
+#define getpid _getpid
+
 #else
 
+#include <cerrno>
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/file.h>
+#include <sys/stat.h>
 
 #endif
 
 toolkit::result<unvm::FileLock> unvm::FileLock::Lock(const std::filesystem::path &path)
+{
+    TraceSpan span("FileLock::Lock");
+
+    return Acquire(path, true);
+}
+
+toolkit::result<unvm::FileLock> unvm::FileLock::TryLock(const std::filesystem::path &path)
+{
+    return Acquire(path, false);
+}
+
+toolkit::result<unvm::FileLock> unvm::FileLock::Acquire(const std::filesystem::path &path, const bool wait)
 {
     const auto path_string = path.string();
 
@@ -39,9 +57,18 @@ toolkit::result<unvm::FileLock> unvm::FileLock::Lock(const std::filesystem::path
 
     OVERLAPPED overlapped{};
 
-    if (!LockFileEx(handle, LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD, &overlapped))
+    const DWORD flags = LOCKFILE_EXCLUSIVE_LOCK | (wait ? 0 : LOCKFILE_FAIL_IMMEDIATELY);
+
+    if (!LockFileEx(handle, flags, 0, MAXDWORD, MAXDWORD, &overlapped))
     {
+        const auto error = GetLastError();
         CloseHandle(handle);
+
+        if (!wait && error == ERROR_LOCK_VIOLATION)
+        {
+            return FileLock();
+        }
+
         return toolkit::make_error("failed to acquire lock.");
     }
 
@@ -56,9 +83,16 @@ toolkit::result<unvm::FileLock> unvm::FileLock::Lock(const std::filesystem::path
         return toolkit::make_error("failed to open lock file.");
     }
 
-    if (flock(fd, LOCK_EX) != 0)
+    if (flock(fd, LOCK_EX | (wait ? 0 : LOCK_NB)) != 0)
     {
+        const auto error = errno;
         close(fd);
+
+        if (!wait && error == EWOULDBLOCK)
+        {
+            return FileLock();
+        }
+
         return toolkit::make_error("failed to acquire lock.");
     }
 
@@ -100,6 +134,19 @@ unvm::FileLock &unvm::FileLock::operator=(FileLock &&other) noexcept
     return *this;
 }
 
+unvm::FileLock::operator bool() const
+{
+#if defined(SYSTEM_WINDOWS)
+
+    return m_Handle;
+
+#else
+
+    return m_Handle >= 0;
+
+#endif
+}
+
 #if defined(SYSTEM_WINDOWS)
 
 unvm::FileLock::FileLock(void *handle)
@@ -116,18 +163,41 @@ unvm::FileLock::FileLock(const int handle)
 
 #endif
 
-static bool try_acquire(const std::filesystem::path &path, std::string_view message)
+static std::string format_marker(const std::string_view message)
 {
-    const auto path_string = path.string();
+    return std::format("{}\n{}\n", message, getpid());
+}
 
 #if defined(SYSTEM_WINDOWS)
 
+/**
+ * Lock a single byte far beyond the end of the marker, as locked ranges can not be read by others on windows, but the
+ * operation in the marker has to stay readable.
+ */
+static BOOL lock_marker(HANDLE handle, const bool wait)
+{
+    OVERLAPPED overlapped{};
+    overlapped.OffsetHigh = 1;
+
+    const DWORD flags = LOCKFILE_EXCLUSIVE_LOCK | (wait ? 0 : LOCKFILE_FAIL_IMMEDIATELY);
+
+    return LockFileEx(handle, flags, 0, 1, 0, &overlapped);
+}
+
+/**
+ * Open and lock the marker file. It stays in place after release, so there is no need to tell apart a released
+ * marker from its replacement.
+ */
+static bool try_acquire(const std::filesystem::path &path, const bool wait, const std::string_view message, void *&out)
+{
+    const auto path_string = path.string();
+
     auto handle = CreateFileA(
         path_string.c_str(),
-        GENERIC_WRITE,
-        0,
+        GENERIC_READ | GENERIC_WRITE,
+        FILE_SHARE_READ | FILE_SHARE_WRITE,
         nullptr,
-        CREATE_NEW,
+        OPEN_ALWAYS,
         FILE_ATTRIBUTE_NORMAL,
         nullptr);
 
@@ -136,30 +206,115 @@ static bool try_acquire(const std::filesystem::path &path, std::string_view mess
         return false;
     }
 
-    WriteFile(handle, message.data(), message.size(), nullptr, nullptr);
+    if (!lock_marker(handle, wait))
+    {
+        CloseHandle(handle);
+        return false;
+    }
+
+    const auto marker = format_marker(message);
+
+    DWORD written;
+    if (SetFilePointer(handle, 0, nullptr, FILE_BEGIN) == INVALID_SET_FILE_POINTER
+        || !WriteFile(handle, marker.data(), static_cast<DWORD>(marker.size()), &written, nullptr)
+        || written != marker.size()
+        || !SetEndOfFile(handle))
+    {
+        CloseHandle(handle);
+        return false;
+    }
+
+    out = handle;
+    return true;
+}
+
+static void release(const std::filesystem::path &, void *handle)
+{
+    OVERLAPPED overlapped{};
+    overlapped.OffsetHigh = 1;
+
+    UnlockFileEx(handle, 0, 1, 0, &overlapped);
     CloseHandle(handle);
+}
 
 #else
 
-    const auto fd = open(path_string.c_str(), O_CREAT | O_EXCL | O_WRONLY, 0666);
+/**
+ * Open and lock the marker file. The holder removes the marker before releasing it, so a lock that was taken on a
+ * marker which is no longer in place does not count, and is taken again on its replacement.
+ */
+static bool try_acquire(const std::filesystem::path &path, const bool wait, const std::string_view message, int &out)
+{
+    const auto path_string = path.string();
 
-    if (fd < 0)
+    for (;;)
     {
-        return false;
-    }
+        const auto fd = open(path_string.c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0666);
+        if (fd < 0)
+        {
+            return false;
+        }
 
-    write(fd, message.data(), message.size());
-    close(fd);
+        int locked;
+        do
+        {
+            locked = flock(fd, LOCK_EX | (wait ? 0 : LOCK_NB));
+        }
+        while (locked && errno == EINTR);
 
-#endif
+        if (locked)
+        {
+            close(fd);
+            return false;
+        }
 
-    return true;
+        struct stat held{}, current{};
+        if (fstat(fd, &held) || stat(path_string.c_str(), &current)
+            || held.st_dev != current.st_dev || held.st_ino != current.st_ino)
+        {
+            close(fd);
+            continue;
+        }
+
+        // the lock is what counts, the content only tells others what the holder is doing. a marker taken over from a
+        // crashed holder still names the old operation, so it is always rewritten.
+        const auto marker = format_marker(message);
+
+        ssize_t written;
+        do
+        {
+            written = ftruncate(fd, 0) ? -1 : write(fd, marker.data(), marker.size());
+        }
+        while (written < 0 && errno == EINTR);
+
+        // a marker that was cut short would tell waiting processes the wrong thing, so the lock is given up again
+        if (written != static_cast<ssize_t>(marker.size()))
+        {
+            unlink(path_string.c_str());
+            close(fd);
+            return false;
+        }
+
+        out = fd;
+        return true;
+    }
+}
+
+static void release(const std::filesystem::path &path, const int handle)
+{
+    unlink(path.c_str());
+    flock(handle, LOCK_UN);
+    close(handle);
 }
 
+#endif
+
 unvm::TryAcquire::TryAcquire(const std::filesystem::path &path, const bool wait, const std::string_view message)
     : m_Path(path)
 {
-    if (try_acquire(path, message))
+    TraceSpan span("TryAcquire");
+
+    if (try_acquire(path, false, message, m_Handle))
     {
         m_Primary = true;
         m_Acquired = true;
@@ -174,18 +329,12 @@ unvm::TryAcquire::TryAcquire(const std::filesystem::path &path, const bool wait,
         return;
     }
 
-    auto delay = 50;
-    for (;;)
-    {
-        if (try_acquire(path, message))
-        {
-            m_Acquired = true;
-            return;
-        }
-
-        std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+    TraceSpan wait_span("TryAcquire::Wait");
 
-        delay = std::min(delay * 2, 1000);
+    if (try_acquire(path, true, message, m_Handle))
+    {
+        m_Acquired = true;
+        m_Message = message;
     }
 }
 
@@ -194,20 +343,26 @@ unvm::TryAcquire::~TryAcquire()
     if (m_Acquired)
     {
         m_Acquired = false;
-        std::filesystem::remove(m_Path);
+        release(m_Path, m_Handle);
     }
 }
 
 unvm::TryAcquire::TryAcquire(TryAcquire &&other) noexcept
 {
     std::swap(m_Acquired, other.m_Acquired);
+    std::swap(m_Primary, other.m_Primary);
     std::swap(m_Path, other.m_Path);
+    std::swap(m_Message, other.m_Message);
+    std::swap(m_Handle, other.m_Handle);
 }
 
 unvm::TryAcquire &unvm::TryAcquire::operator=(TryAcquire &&other) noexcept
 {
     std::swap(m_Acquired, other.m_Acquired);
+    std::swap(m_Primary, other.m_Primary);
     std::swap(m_Path, other.m_Path);
+    std::swap(m_Message, other.m_Message);
+    std::swap(m_Handle, other.m_Handle);
     return *this;
 }
 
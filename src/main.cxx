@@ -1,5 +1,7 @@
+#include <unvm/cache.hxx>
 #include <unvm/config.hxx>
 #include <unvm/semver.hxx>
+#include <unvm/trace.hxx>
 #include <unvm/unvm.hxx>
 #include <unvm/util.hxx>
 #include <unvm/http/http.hxx>
@@ -17,6 +19,7 @@ enum class Operation
     List,
     Complete,
     Execute,
+    Daemon,
 };
 
 static const std::map<std::string_view, Operation> operation_map
@@ -35,52 +38,18 @@ static const std::map<std::string_view, Operation> operation_map
     { "exec", Operation::Execute },
     { "e", Operation::Execute },
     { "x", Operation::Execute },
-};
-
-static const toolkit::arg_manifest manifest
-{
-    {
-        {
-            .id = "help",
-            .kind = toolkit::arg_kind::flag,
-            .patterns = { "?", "-?", "-h", "--help" },
-        },
-        {
-            .id = "local",
-            .kind = toolkit::arg_kind::flag,
-            .patterns = { "-l", "--local" },
-        },
-        {
-            .id = "available",
-            .kind = toolkit::arg_kind::flag,
-            .patterns = { "-a", "--available" },
-        },
-        {
-            .id = "flat",
-            .kind = toolkit::arg_kind::flag,
-            .patterns = { "-f", "--flat" },
-        },
-        {
-            .id = "details",
-            .kind = toolkit::arg_kind::flag,
-            .patterns = { "-d", "--details" },
-        },
-        {
-            .id = "yes",
-            .kind = toolkit::arg_kind::flag,
-            .patterns = { "-y", "--yes" },
-        },
-    },
+    { "daemon", Operation::Daemon },
+    { "d", Operation::Daemon },
 };
 
 [[nodiscard]] static toolkit::result<> execute(
     unvm::Config &config,
-    unvm::http::HttpClient &client,
+    unvm::ResolutionContext &resolution,
     const int argc,
     char **argv)
 {
     toolkit::arg_context args;
-    if (auto res = toolkit::arg_parse(manifest, argc, argv) >> args; !res)
+    if (auto res = toolkit::arg_parse(unvm::Manifest, argc, argv) >> args; !res)
         return res;
 
     if (args.empty() || args.is("help"))
@@ -103,7 +72,7 @@ static const toolkit::arg_manifest manifest
             return toolkit::make_error("invalid argument count.");
         }
 
-        return Install(config, client, args[1]);
+        return Install(config, resolution, args[1]);
 
     case Operation::Remove:
         if (args.size() != 2)
@@ -111,7 +80,7 @@ static const toolkit::arg_manifest manifest
             return toolkit::make_error("invalid argument count.");
         }
 
-        return Remove(config, client, args[1]);
+        return Remove(config, resolution, args[1]);
 
     case Operation::Use:
     {
@@ -122,7 +91,7 @@ static const toolkit::arg_manifest manifest
 
         const auto local = args.is("local");
 
-        return Use(config, client, args[1], local);
+        return Use(config, resolution, args[1], local);
     }
 
     case Operation::List:
@@ -136,7 +105,7 @@ static const toolkit::arg_manifest manifest
         const auto flat = args.is("flat");
         const auto details = args.is("details");
 
-        return List(config, client, available, flat, details);
+        return List(config, resolution, available, flat, details);
     }
 
     case Operation::Complete:
@@ -147,10 +116,10 @@ static const toolkit::arg_manifest manifest
             line[i] = args[i].data();
 
         toolkit::arg_context context;
-        if (auto res = toolkit::arg_parse(manifest, static_cast<int>(line.size()), line.data()) >> context; !res)
+        if (auto res = toolkit::arg_parse(unvm::Manifest, static_cast<int>(line.size()), line.data()) >> context; !res)
             return res;
 
-        return unvm::Complete(config, client, context);
+        return unvm::Complete(config, resolution, context);
     }
 
     case Operation::Execute:
@@ -184,12 +153,20 @@ static const toolkit::arg_manifest manifest
             line[i - count] = args[i].data();
 
         toolkit::arg_context context;
-        if (auto res = toolkit::arg_parse(manifest, static_cast<int>(line.size()), line.data()) >> context; !res)
+        if (auto res = toolkit::arg_parse(unvm::Manifest, static_cast<int>(line.size()), line.data()) >> context; !res)
             return res;
 
-        return unvm::Execute(config, client, version, yes, context);
+        return unvm::Execute(config, resolution, version, yes, context);
     }
 
+    case Operation::Daemon:
+        if (args.size() != 1)
+        {
+            return toolkit::make_error("invalid argument count.");
+        }
+
+        return unvm::Daemon(config, resolution.Client());
+
     default:
         return toolkit::make_error("operation '{}' not implemented.", args[0]);
     }
@@ -200,8 +177,45 @@ int main(const int argc, char **argv)
     const auto exec = std::filesystem::path(argv[0]);
     const auto stem = exec.stem().string();
 
+    // a parent shim, e.g. the one npm runs scripts from, or a running daemon may already know the answer, in which
+    // case there is no need to read the config at all
+    if (stem != "unvm")
+    {
+        const auto directory = std::filesystem::current_path();
+
+        std::optional<std::string> version;
+        if (unvm::ResolutionEntry inherited; unvm::ImportResolution(directory, inherited) && inherited.Direct)
+        {
+            version = std::move(inherited.Resolved);
+        }
+        else
+        {
+            version = unvm::QueryDaemon(directory);
+        }
+
+        if (version)
+        {
+            toolkit::arg_context context;
+            if (auto res = toolkit::arg_parse(unvm::Manifest, argc, argv) >> context; !res)
+            {
+                std::cerr << res.error() << std::endl;
+                return 1;
+            }
+
+            if (auto res = unvm::Shim(*version, context); !res)
+            {
+                std::cerr << res.error() << std::endl;
+                return 1;
+            }
+        }
+    }
+
     unvm::Config config;
     unvm::http::HttpClient client;
+    unvm::ResolutionContext resolution(config, client);
+
+    // open the cache before reading the config, so a concurrent change always outdates the cached state
+    auto cache = unvm::ResolutionCache::Open();
 
     if (auto res = unvm::ReadConfigFile(config); !res)
     {
@@ -209,41 +223,35 @@ int main(const int argc, char **argv)
         return 1;
     }
 
-    unvm::VersionType type{};
+    // the working directory is already absolute and free of symlinks on posix, so no need to canonicalize it
+    const auto directory = std::filesystem::current_path();
+
+    unvm::ResolutionEntry resolved;
+    if (cache.Find(directory, resolved))
+    {
+        config.Detected = resolved.Version;
+        config.Active = resolved.Resolved;
 
-    if (auto res = unvm::FindActiveVersion(config.Default, &type) >> config.Detected; !res)
+        resolution.SetActiveVersion(config.Detected, resolved.Type);
+    }
+    else if (auto res = unvm::ResolveActiveVersion(config, resolution, resolved); !res)
     {
         std::cerr << res.error() << std::endl;
         return 1;
     }
-
-    if (config.Detected)
+    else
     {
-        unvm::VersionTable table;
-        if (auto res = unvm::LoadVersionTable(client, table, false); !res)
-        {
-            std::cerr << res.error() << std::endl;
-            return 1;
-        }
+        cache.Insert(directory, resolved);
 
-        unvm::FilterVersionTable(config, table, true, true);
-
-        const unvm::VersionEntry *entry{};
-        if (auto res = unvm::FindVersionEntry(table, *config.Detected) >> entry; !res)
+        if (auto save_res = cache.Save(); !save_res)
         {
-            std::cerr << res.error() << std::endl;
-            return 1;
-        }
-
-        if (entry)
-        {
-            config.Active = entry->Version;
+            std::cerr << "warning: failed to save resolution cache: " << save_res.error() << std::endl;
         }
     }
 
     if (stem == "unvm")
     {
-        if (auto res = execute(config, client, argc, argv); !res)
+        if (auto res = execute(config, resolution, argc, argv); !res)
         {
             std::cerr << res.error() << std::endl;
             return 1;
@@ -265,13 +273,26 @@ int main(const int argc, char **argv)
     }
 
     toolkit::arg_context context;
-    if (auto res = toolkit::arg_parse(manifest, argc, argv) >> context; !res)
+    if (auto res = toolkit::arg_parse(unvm::Manifest, argc, argv) >> context; !res)
     {
         std::cerr << res.error() << std::endl;
         return 1;
     }
 
-    if (auto res = unvm::Execute(config, client, *config.Detected, false, context); !res)
+    // the active version is already resolved and installed, and no newer version would be offered to install, so there
+    // is nothing left for Execute to do
+    if (resolved.Direct && config.Active && unvm::IsInstalled(config, *config.Active))
+    {
+        unvm::ExportResolution(directory, resolved);
+
+        if (auto res = unvm::Shim(*config.Active, context); !res)
+        {
+            std::cerr << res.error() << std::endl;
+            return 1;
+        }
+    }
+
+    if (auto res = unvm::Execute(config, resolution, *config.Detected, false, context); !res)
     {
         std::cerr << res.error() << std::endl;
         return 1;
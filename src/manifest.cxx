@@ -0,0 +1,37 @@
+#include <unvm/unvm.hxx>
+
+const toolkit::arg_manifest unvm::Manifest
+{
+    {
+        {
+            .id = "help",
+            .kind = toolkit::arg_kind::flag,
+            .patterns = { "?", "-?", "-h", "--help" },
+        },
+        {
+            .id = "local",
+            .kind = toolkit::arg_kind::flag,
+            .patterns = { "-l", "--local" },
+        },
+        {
+            .id = "available",
+            .kind = toolkit::arg_kind::flag,
+            .patterns = { "-a", "--available" },
+        },
+        {
+            .id = "flat",
+            .kind = toolkit::arg_kind::flag,
+            .patterns = { "-f", "--flat" },
+        },
+        {
+            .id = "details",
+            .kind = toolkit::arg_kind::flag,
+            .patterns = { "-d", "--details" },
+        },
+        {
+            .id = "yes",
+            .kind = toolkit::arg_kind::flag,
+            .patterns = { "-y", "--yes" },
+        },
+    },
+};
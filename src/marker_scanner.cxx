@@ -0,0 +1,200 @@
+#include <unvm/scanner.hxx>
+
+#if defined(SYSTEM_LINUX) || defined(SYSTEM_ANDROID) || defined(SYSTEM_DARWIN)
+
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+// a level only needs search permission, like for a walk over paths, so the handles are never opened for reading
+#if defined(O_PATH)
+static constexpr auto open_flags = O_PATH | O_DIRECTORY | O_CLOEXEC;
+#elif defined(O_SEARCH)
+static constexpr auto open_flags = O_SEARCH | O_DIRECTORY | O_CLOEXEC;
+#else
+static constexpr auto open_flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC;
+#endif
+
+toolkit::result<unvm::MarkerScanner> unvm::MarkerScanner::Open()
+{
+    std::error_code ec;
+
+    // the working directory is already free of symlinks, so the fd walk below matches the path walk
+    auto path = std::filesystem::current_path(ec).string();
+    if (ec)
+    {
+        return toolkit::make_error("failed to get current directory: {} ({}).", ec.message(), ec.value());
+    }
+
+    // where a handle still needs read permission, a directory without it is scanned by path instead
+    const auto handle = open(".", open_flags);
+    if (handle < 0 && errno != EACCES)
+    {
+        return toolkit::make_error("failed to open current directory.");
+    }
+
+    MarkerScanner scanner;
+    scanner.m_Path = std::move(path);
+    scanner.m_Handle = handle;
+    return scanner;
+}
+
+unvm::MarkerScanner::~MarkerScanner()
+{
+    if (m_Handle >= 0)
+    {
+        close(m_Handle);
+    }
+}
+
+bool unvm::MarkerScanner::Find(const char *name, FileStamp *stamp) const
+{
+    if (m_Handle < 0)
+    {
+        if (stamp)
+        {
+            return GetFileStamp(Path(name), *stamp);
+        }
+
+        return !access(Path(name).c_str(), F_OK);
+    }
+
+    if (stamp)
+    {
+        return GetFileStamp(m_Handle, name, *stamp);
+    }
+
+    return !faccessat(m_Handle, name, F_OK, 0);
+}
+
+bool unvm::MarkerScanner::Stamp(FileStamp &stamp) const
+{
+    if (m_Handle < 0)
+    {
+        return GetFileStamp(m_Path, stamp);
+    }
+
+    return GetFileStamp(m_Handle, ".", stamp);
+}
+
+std::filesystem::path unvm::MarkerScanner::Path() const
+{
+    return m_Path;
+}
+
+std::filesystem::path unvm::MarkerScanner::Path(const std::string_view name) const
+{
+    std::string path = m_Path;
+    if (!path.ends_with('/'))
+    {
+        path += '/';
+    }
+    path += name;
+
+    return path;
+}
+
+bool unvm::MarkerScanner::Up()
+{
+    const auto separator = m_Path.find_last_of('/');
+    if (separator == std::string::npos || m_Path.size() == 1)
+    {
+        return false;
+    }
+
+    if (m_Handle >= 0)
+    {
+        // from a level that cannot be opened, the walk goes on by path
+        const auto parent = openat(m_Handle, "..", open_flags);
+        if (parent < 0 && errno != EACCES)
+        {
+            return false;
+        }
+
+        close(m_Handle);
+        m_Handle = parent;
+    }
+
+    m_Path.resize(separator ? separator : 1);
+    return true;
+}
+
+#endif
+
+#if defined(SYSTEM_WINDOWS)
+
+toolkit::result<unvm::MarkerScanner> unvm::MarkerScanner::Open()
+{
+    std::error_code ec;
+
+    auto path = std::filesystem::weakly_canonical(std::filesystem::current_path(ec), ec);
+    if (ec)
+    {
+        return toolkit::make_error("failed to get current directory: {} ({}).", ec.message(), ec.value());
+    }
+
+    MarkerScanner scanner;
+    scanner.m_Path = std::move(path);
+    return scanner;
+}
+
+unvm::MarkerScanner::~MarkerScanner() = default;
+
+bool unvm::MarkerScanner::Find(const char *name, FileStamp *stamp) const
+{
+    if (stamp)
+    {
+        return GetFileStamp(m_Path / name, *stamp);
+    }
+
+    std::error_code ec;
+    return std::filesystem::exists(m_Path / name, ec);
+}
+
+bool unvm::MarkerScanner::Stamp(FileStamp &stamp) const
+{
+    return GetFileStamp(m_Path, stamp);
+}
+
+std::filesystem::path unvm::MarkerScanner::Path() const
+{
+    return m_Path;
+}
+
+std::filesystem::path unvm::MarkerScanner::Path(const std::string_view name) const
+{
+    return m_Path / name;
+}
+
+bool unvm::MarkerScanner::Up()
+{
+    auto parent = m_Path.parent_path();
+    if (parent == m_Path)
+    {
+        return false;
+    }
+
+    m_Path = std::move(parent);
+    return true;
+}
+
+#endif
+
+unvm::MarkerScanner::MarkerScanner(MarkerScanner &&other) noexcept
+{
+    *this = std::move(other);
+}
+
+unvm::MarkerScanner &unvm::MarkerScanner::operator=(MarkerScanner &&other) noexcept
+{
+    std::swap(m_Path, other.m_Path);
+
+#if !defined(SYSTEM_WINDOWS)
+
+    std::swap(m_Handle, other.m_Handle);
+
+#endif
+
+    return *this;
+}
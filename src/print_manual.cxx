@@ -16,7 +16,7 @@ void unvm::PrintManual()
             << "  unvm [<option|flag>...] [--] [<option>...]\n"
             << "\n"
             << "Options:\n"
-            << "  i, install, r, remove, u, use, l, list, c, complete, x, e, exec, execute\n"
+            << "  i, install, r, remove, u, use, l, list, c, complete, x, e, exec, execute, d, daemon\n"
             << "\n"
             << "Global Flags:\n"
             << "  ?, -?, -h, --help  Print this manual.\n"
@@ -31,6 +31,7 @@ void unvm::PrintManual()
             << "  list,             l [-a|--available] [-f|--flat] [-d|--details]  List installed versions. Use `-a` or `--available` to list version available online. Use `-f` or `--flat` to print as a flat list. Use `-d` or `--details` to print more details and subversions.\n"
             << "  complete,         c -- ...                                       Print a list of available auto-complete options to standard out.\n"
             << "  execute, exec, e, x [<version>] [-y|--yes] -- ...                Execute the given command within the context of the specified Node.js version, or the detected Node.js version if omitted. Use `-y` or `--yes` to skip confirmation on auto-installing missing versions.\n"
+            << "  daemon,           d                                              Keep resolutions in memory and serve them to shims until interrupted (linux only).\n"
             << "\n"
             << "Examples:\n"
             << "  unvm ?\n"
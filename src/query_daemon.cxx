@@ -0,0 +1,84 @@
+#include <unvm/trace.hxx>
+#include <unvm/unvm.hxx>
+#include <unvm/util.hxx>
+
+#if defined(SYSTEM_LINUX) || defined(SYSTEM_ANDROID)
+
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+std::optional<std::string> unvm::QueryDaemon(const std::filesystem::path &directory)
+{
+    TraceSpan span("QueryDaemon");
+
+    const auto path = (GetDataDirectory() / DaemonSocketName).string();
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+
+    if (path.size() >= sizeof(address.sun_path))
+    {
+        return std::nullopt;
+    }
+
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+    const auto handle = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (handle < 0)
+    {
+        return std::nullopt;
+    }
+
+    // a daemon that does not answer right away is no better than resolving in-process
+    constexpr timeval timeout{ .tv_sec = 0, .tv_usec = 50000 };
+    setsockopt(handle, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(handle, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    if (connect(handle, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0)
+    {
+        close(handle);
+        return std::nullopt;
+    }
+
+    const auto request = directory.string() + '\n';
+    if (send(handle, request.data(), request.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(request.size()))
+    {
+        close(handle);
+        return std::nullopt;
+    }
+
+    std::string response;
+
+    char buffer[256];
+    for (;;)
+    {
+        const auto count = recv(handle, buffer, sizeof(buffer), 0);
+        if (count <= 0)
+        {
+            break;
+        }
+
+        response.append(buffer, count);
+    }
+
+    close(handle);
+
+    if (!response.ends_with('\n') || response.size() == 1)
+    {
+        return std::nullopt;
+    }
+
+    response.pop_back();
+    return response;
+}
+
+#else
+
+std::optional<std::string> unvm::QueryDaemon(const std::filesystem::path &)
+{
+    return std::nullopt;
+}
+
+#endif
@@ -4,18 +4,10 @@
 
 #include <iostream>
 
-toolkit::result<> unvm::Remove(Config &config, http::HttpClient &client, const std::string_view version)
+toolkit::result<> unvm::Remove(Config &config, ResolutionContext &resolution, const std::string_view version)
 {
-    VersionTable table;
-    if (auto res = LoadVersionTable(client, table, false); !res)
-    {
-        return res;
-    }
-
-    FilterVersionTable(config, table, true, true);
-
-    const VersionEntry *entry{};
-    if (auto res = FindVersionEntry(table, version) >> entry; !res)
+    VersionEntry entry;
+    if (auto res = resolution.Find(version, false, true) >> entry; !res)
     {
         return res;
     }
@@ -26,8 +18,11 @@ toolkit::result<> unvm::Remove(Config &config, http::HttpClient &client, const s
         return {};
     }
 
+    // copy the version, the entry does not outlive the invalidation below
+    const std::string entry_version(entry.Version());
+
     const auto data_directory = GetDataDirectory();
-    const auto lock_path = data_directory / (entry->Version + ".lock");
+    const auto lock_path = data_directory / (entry_version + ".lock");
 
     TryAcquire lock(lock_path, false, "remove");
     if (!lock)
@@ -48,9 +43,11 @@ toolkit::result<> unvm::Remove(Config &config, http::HttpClient &client, const s
 
     (void) lock;
 
-    std::filesystem::remove_all(data_directory / entry->Version);
+    std::filesystem::remove_all(data_directory / entry_version);
+
+    config.Installed.erase(entry_version);
+    config.RemovedVersions.insert(entry_version);
 
-    config.Installed.erase(entry->Version);
-    config.RemovedVersions.insert(entry->Version);
+    resolution.Invalidate();
     return {};
 }
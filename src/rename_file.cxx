@@ -0,0 +1,38 @@
+#include <unvm/util.hxx>
+
+#if defined(SYSTEM_WINDOWS)
+
+#define NOMINMAX
+
+#include <chrono>
+#include <thread>
+#include <windows.h>
+
+void unvm::RenameFile(const std::filesystem::path &from, const std::filesystem::path &to, std::error_code &ec)
+{
+    // readers open files without FILE_SHARE_DELETE, so replacing one fails for as long as any reader has it open. that
+    // is only while it is read, so retry with a growing delay, for about a second in total
+    auto delay = std::chrono::milliseconds(1);
+
+    for (auto attempt = 0;; ++attempt)
+    {
+        std::filesystem::rename(from, to, ec);
+
+        if (!ec || attempt == 10 || (ec.value() != ERROR_ACCESS_DENIED && ec.value() != ERROR_SHARING_VIOLATION))
+        {
+            return;
+        }
+
+        std::this_thread::sleep_for(delay);
+        delay *= 2;
+    }
+}
+
+#else
+
+void unvm::RenameFile(const std::filesystem::path &from, const std::filesystem::path &to, std::error_code &ec)
+{
+    std::filesystem::rename(from, to, ec);
+}
+
+#endif
@@ -0,0 +1,430 @@
+#include <unvm/cache.hxx>
+#include <unvm/scanner.hxx>
+#include <unvm/trace.hxx>
+#include <unvm/util.hxx>
+
+#include <charconv>
+#include <cstdlib>
+#include <fstream>
+
+#if defined(SYSTEM_WINDOWS)
+
+#include <process.h>
+
+#define getpid _getpid
+
+#else
+
+#include <unistd.h>
+
+#endif
+
+static constexpr std::string_view magic = "unvm-resolve\t3";
+
+static std::vector<std::string_view> split_fields(const std::string_view line)
+{
+    std::vector<std::string_view> fields;
+
+    for (size_t begin = 0;;)
+    {
+        const auto end = line.find('\t', begin);
+        fields.push_back(line.substr(begin, end - begin));
+
+        if (end == std::string_view::npos)
+        {
+            return fields;
+        }
+
+        begin = end + 1;
+    }
+}
+
+template<typename T>
+[[nodiscard]] static bool parse_field(const std::string_view field, T &value)
+{
+    auto [ptr, ec] = std::from_chars(field.data(), field.data() + field.size(), value);
+    return ec == std::errc() && ptr == field.data() + field.size();
+}
+
+static void format_optional(std::string &dst, const std::optional<std::string> &value)
+{
+    if (value)
+    {
+        dst += '+';
+        dst += *value;
+    }
+    else
+    {
+        dst += '-';
+    }
+}
+
+[[nodiscard]] static bool parse_optional(const std::string_view field, std::optional<std::string> &value)
+{
+    if (field == "-")
+    {
+        value = std::nullopt;
+        return true;
+    }
+
+    if (field.starts_with('+'))
+    {
+        value = std::string(field.substr(1));
+        return true;
+    }
+
+    return false;
+}
+
+static void format_stamp(std::string &dst, const unvm::FileStamp &stamp)
+{
+    dst += std::to_string(stamp.Time);
+    dst += '\t';
+    dst += std::to_string(stamp.Inode);
+    dst += '\t';
+    dst += std::to_string(stamp.Size);
+}
+
+static unvm::FileStamp get_stamp_or_empty(const std::filesystem::path &path)
+{
+    unvm::FileStamp stamp;
+    if (!unvm::GetFileStamp(path, stamp))
+    {
+        return {};
+    }
+
+    return stamp;
+}
+
+[[nodiscard]] static bool is_plain(const std::string_view value)
+{
+    return value.find_first_of("\t\r\n") == std::string_view::npos;
+}
+
+static std::string format_header(const std::filesystem::path &data_directory)
+{
+    std::string header(magic);
+    header += '\t';
+    format_stamp(header, get_stamp_or_empty(data_directory / "config.json"));
+    header += '\t';
+    format_stamp(header, get_stamp_or_empty(data_directory / "index.json"));
+    return header;
+}
+
+/**
+ * Format one resolution as '<directory> <type> <version> <resolved> <direct> <count> (<path> <time> <inode>
+ * <size>)...', separated by tabs. Fails if any of the fields contains a separator.
+ */
+[[nodiscard]] static bool format_line(std::string &line, const std::string &key, const unvm::ResolutionEntry &entry)
+{
+    if (!is_plain(key)
+        || (entry.Version && !is_plain(*entry.Version))
+        || (entry.Resolved && !is_plain(*entry.Resolved)))
+    {
+        return false;
+    }
+
+    line += key;
+    line += '\t';
+    line += std::to_string(static_cast<int>(entry.Type));
+    line += '\t';
+    format_optional(line, entry.Version);
+    line += '\t';
+    format_optional(line, entry.Resolved);
+    line += '\t';
+    line += entry.Direct ? '1' : '0';
+    line += '\t';
+    line += std::to_string(entry.Dependencies.size());
+
+    for (auto &[path, stamp] : entry.Dependencies)
+    {
+        const auto path_string = path.string();
+        if (!is_plain(path_string))
+        {
+            return false;
+        }
+
+        line += '\t';
+        line += path_string;
+        line += '\t';
+        format_stamp(line, stamp);
+    }
+
+    return true;
+}
+
+/**
+ * Parse a line written by format_line, and check that none of the dependencies changed since.
+ */
+[[nodiscard]] static bool parse_line(const std::string_view line, unvm::ResolutionEntry &entry)
+{
+    const auto fields = split_fields(line);
+    if (fields.size() < 6)
+    {
+        return false;
+    }
+
+    int type;
+    size_t count;
+    if (!parse_field(fields[1], type)
+        || !parse_optional(fields[2], entry.Version)
+        || !parse_optional(fields[3], entry.Resolved)
+        || (fields[4] != "0" && fields[4] != "1")
+        || !parse_field(fields[5], count)
+        || fields.size() != 6 + count * 4)
+    {
+        return false;
+    }
+
+    entry.Type = static_cast<unvm::VersionType>(type);
+    entry.Direct = fields[4] == "1";
+    entry.Dependencies.resize(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto &[path, stamp] = entry.Dependencies[i];
+        const auto base = 6 + i * 4;
+
+        path = fields[base];
+
+        if (!parse_field(fields[base + 1], stamp.Time)
+            || !parse_field(fields[base + 2], stamp.Inode)
+            || !parse_field(fields[base + 3], stamp.Size))
+        {
+            return false;
+        }
+
+        if (unvm::FileStamp current; !unvm::GetFileStamp(path, current) || current != stamp)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+unvm::ResolutionCache unvm::ResolutionCache::Open()
+{
+    TraceSpan span("ResolutionCache::Open");
+
+    const auto data_directory = GetDataDirectory();
+
+    ResolutionCache cache;
+    cache.m_Path = data_directory / "resolve.cache";
+
+    cache.m_Header = format_header(data_directory);
+
+    std::ifstream stream(cache.m_Path);
+    if (!stream)
+    {
+        return cache;
+    }
+
+    std::string line;
+    if (!std::getline(stream, line) || line != cache.m_Header)
+    {
+        return cache;
+    }
+
+    while (std::getline(stream, line))
+    {
+        if (!line.empty())
+        {
+            cache.m_Lines.push_back(std::move(line));
+        }
+    }
+
+    return cache;
+}
+
+bool unvm::ResolutionCache::Find(const std::filesystem::path &directory, ResolutionEntry &entry) const
+{
+    const auto key = directory.string();
+
+    for (auto it = m_Lines.rbegin(); it != m_Lines.rend(); ++it)
+    {
+        const std::string_view line = *it;
+        if (!line.starts_with(key) || line.size() <= key.size() || line[key.size()] != '\t')
+        {
+            continue;
+        }
+
+        return parse_line(line, entry);
+    }
+
+    return false;
+}
+
+void unvm::ResolutionCache::Insert(const std::filesystem::path &directory, const ResolutionEntry &entry)
+{
+    const auto key = directory.string();
+
+    std::string line;
+    if (!format_line(line, key, entry))
+    {
+        return;
+    }
+
+    std::erase_if(
+        m_Lines,
+        [&key](const std::string &l)
+        {
+            return l.starts_with(key) && l.size() > key.size() && l[key.size()] == '\t';
+        });
+
+    m_Lines.push_back(std::move(line));
+
+    if (m_Lines.size() > Capacity)
+    {
+        m_Lines.erase(m_Lines.begin(), m_Lines.end() - Capacity);
+    }
+
+    m_Dirty = true;
+}
+
+toolkit::result<> unvm::ResolutionCache::Save()
+{
+    TraceSpan span("ResolutionCache::Save");
+
+    if (!m_Dirty)
+    {
+        return {};
+    }
+
+    auto temp_path = m_Path;
+    temp_path += std::format(".{}", getpid());
+
+    {
+        std::ofstream stream(temp_path, std::ios::trunc);
+        if (!stream)
+        {
+            return toolkit::make_error("failed to open '{}'.", temp_path.string());
+        }
+
+        stream << m_Header << '\n';
+        for (auto &line : m_Lines)
+        {
+            stream << line << '\n';
+        }
+
+        if (!stream)
+        {
+            return toolkit::make_error("failed to write '{}'.", temp_path.string());
+        }
+    }
+
+    if (std::error_code ec; RenameFile(temp_path, m_Path, ec), ec)
+    {
+        std::error_code remove_ec;
+        std::filesystem::remove(temp_path, remove_ec);
+
+        return toolkit::make_error("failed to rename resolution cache: {} ({}).", ec.message(), ec.value());
+    }
+
+    m_Dirty = false;
+    return {};
+}
+
+void unvm::ExportResolution(const std::filesystem::path &directory, const ResolutionEntry &entry)
+{
+    const auto data_directory = GetDataDirectory();
+    const auto data_directory_string = data_directory.string();
+
+    if (!is_plain(data_directory_string))
+    {
+        return;
+    }
+
+    // <header> <data directory> <line>
+    auto record = format_header(data_directory);
+    record += '\t';
+    record += data_directory_string;
+    record += '\t';
+
+    if (!format_line(record, directory.string(), entry))
+    {
+        return;
+    }
+
+#if defined(SYSTEM_WINDOWS)
+
+    _putenv_s(ResolvedVariable, record.c_str());
+
+#else
+
+    setenv(ResolvedVariable, record.c_str(), 1);
+
+#endif
+}
+
+bool unvm::ImportResolution(const std::filesystem::path &directory, ResolutionEntry &entry)
+{
+    TraceSpan span("ImportResolution");
+
+    const auto variable = std::getenv(ResolvedVariable);
+    if (!variable)
+    {
+        return false;
+    }
+
+    const auto data_directory = GetDataDirectory();
+
+    auto prefix = format_header(data_directory);
+    prefix += '\t';
+    prefix += data_directory.string();
+    prefix += '\t';
+
+    std::string_view record = variable;
+    if (!record.starts_with(prefix))
+    {
+        return false;
+    }
+
+    record.remove_prefix(prefix.size());
+
+    const auto anchor = record.substr(0, record.find('\t'));
+    const auto directory_string = directory.string();
+
+    if (anchor.empty() || !directory_string.starts_with(anchor))
+    {
+        return false;
+    }
+
+    // a sibling that merely shares the prefix, like /work/app-old for /work/app, is not below the anchor
+    const auto is_separator = [](const char c)
+    {
+        return c == '/' || c == static_cast<char>(std::filesystem::path::preferred_separator);
+    };
+
+    if (directory_string.size() != anchor.size()
+        && !is_separator(anchor.back())
+        && !is_separator(directory_string[anchor.size()]))
+    {
+        return false;
+    }
+
+    // below the anchor, the levels in between must not have a say, so any marker there means resolving again
+    if (directory_string.size() != anchor.size())
+    {
+        MarkerScanner scanner;
+        if (auto res = MarkerScanner::Open() >> scanner; !res)
+        {
+            return false;
+        }
+
+        for (;;)
+        {
+            if (scanner.Find(VersionFileName) || scanner.Find(PackageFileName) || !scanner.Up())
+            {
+                return false;
+            }
+
+            if (scanner.Path().string() == anchor)
+            {
+                break;
+            }
+        }
+    }
+
+    return parse_line(record, entry);
+}
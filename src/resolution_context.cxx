@@ -0,0 +1,114 @@
+#include <unvm/context.hxx>
+#include <unvm/unvm.hxx>
+
+unvm::ResolutionContext::ResolutionContext(const Config &config, http::HttpClient &client)
+    : m_Config(config),
+      m_Client(client)
+{
+}
+
+unvm::http::HttpClient &unvm::ResolutionContext::Client() const
+{
+    return m_Client;
+}
+
+toolkit::result<const unvm::VersionView *> unvm::ResolutionContext::Table(const bool online, const bool installed)
+{
+    if (!m_Table || (online && !m_Online))
+    {
+        auto table = std::make_shared<VersionTable>();
+        if (auto res = LoadVersionTable(m_Client, *table, online); !res)
+        {
+            return res;
+        }
+
+        m_Table = std::move(table);
+        m_Online = online;
+
+        m_Supported = FilterVersionTable(m_Config, VersionView(m_Table), true);
+        m_SupportedLookup = VersionLookup(*m_Supported);
+
+        m_Installed.reset();
+        m_Entries.clear();
+    }
+
+    if (!installed)
+    {
+        return &*m_Supported;
+    }
+
+    if (!m_Installed)
+    {
+        m_Installed = FilterVersionTable(m_Config, *m_Supported, false, true);
+        m_InstalledLookup = VersionLookup(*m_Installed);
+    }
+
+    return &*m_Installed;
+}
+
+toolkit::result<unvm::VersionEntry> unvm::ResolutionContext::Find(
+    const std::string_view version,
+    const bool online,
+    const bool installed)
+{
+    const VersionView *view;
+    if (auto res = Table(online, installed) >> view; !res)
+    {
+        return res;
+    }
+
+    std::pair key(installed, std::string(version));
+
+    if (const auto it = m_Entries.find(key); it != m_Entries.end())
+    {
+        return it->second;
+    }
+
+    VersionEntry entry;
+    if (auto res = FindVersionEntry(*view, installed ? m_InstalledLookup : m_SupportedLookup, version) >> entry; !res)
+    {
+        return res;
+    }
+
+    m_Entries.emplace(std::move(key), entry);
+    return entry;
+}
+
+toolkit::result<std::optional<std::string>> unvm::ResolutionContext::ActiveVersion(VersionType *type)
+{
+    if (!m_HasActive)
+    {
+        if (auto res = FindActiveVersion(m_Config.Default, &m_ActiveType) >> m_Active; !res)
+        {
+            return res;
+        }
+
+        m_HasActive = true;
+    }
+
+    if (type)
+    {
+        *type = m_ActiveType;
+    }
+
+    return m_Active;
+}
+
+void unvm::ResolutionContext::SetActiveVersion(std::optional<std::string> version, const VersionType type)
+{
+    m_Active = std::move(version);
+    m_ActiveType = type;
+    m_HasActive = true;
+}
+
+void unvm::ResolutionContext::Invalidate()
+{
+    m_Installed.reset();
+
+    std::erase_if(
+        m_Entries,
+        [](auto &pair)
+        {
+            return pair.first.first;
+        });
+}
@@ -0,0 +1,111 @@
+#include <unvm/cache.hxx>
+#include <unvm/trace.hxx>
+#include <unvm/unvm.hxx>
+#include <unvm/util.hxx>
+
+/**
+ * Normalize an exact version spec like '20.11.1' or 'v20.11.1' to the 'v<major>.<minor>.<patch>' form used by the
+ * version table. Anything else, like ranges, aliases or LTS names, needs the table to resolve.
+ */
+static std::optional<std::string> get_exact_version(std::string_view spec)
+{
+    if (spec.starts_with('v'))
+    {
+        spec.remove_prefix(1);
+    }
+
+    auto parts = 0;
+    auto digits = 0;
+
+    for (const auto c : spec)
+    {
+        if (std::isdigit(static_cast<unsigned char>(c)))
+        {
+            ++digits;
+            continue;
+        }
+
+        if (c != '.' || !digits)
+        {
+            return std::nullopt;
+        }
+
+        ++parts;
+        digits = 0;
+    }
+
+    if (parts != 2 || !digits)
+    {
+        return std::nullopt;
+    }
+
+    return 'v' + std::string(spec);
+}
+
+bool unvm::IsInstalled(const Config &config, const std::string &version)
+{
+    if (!config.Installed.contains(version))
+    {
+        return false;
+    }
+
+    std::error_code ec;
+    return std::filesystem::exists(GetNodeExecutable(version), ec);
+}
+
+toolkit::result<> unvm::ResolveActiveVersion(
+    Config &config,
+    ResolutionContext &resolution,
+    ResolutionEntry &resolved)
+{
+    TraceSpan span("ResolveActiveVersion");
+
+    if (auto res = FindActiveVersion(config.Default, &resolved.Type, &resolved.Dependencies)
+                   >> config.Detected; !res)
+    {
+        return res;
+    }
+
+    resolution.SetActiveVersion(config.Detected, resolved.Type);
+
+    auto direct = false;
+
+    // an installed exact pin, which includes the default as 'use' stores it resolved, needs no version table
+    if (config.Detected)
+    {
+        if (auto exact = get_exact_version(*config.Detected); exact && config.Installed.contains(*exact))
+        {
+            config.Active = std::move(exact);
+            direct = true;
+        }
+    }
+
+    // anything else, like a range, an alias or an LTS name, resolves against the installed versions. a shim may only
+    // run that match directly if no newer supported version matches, since Execute offers to install that one instead
+    if (config.Detected && !config.Active)
+    {
+        VersionEntry entry;
+        if (auto res = resolution.Find(*config.Detected, false, true) >> entry; !res)
+        {
+            return res;
+        }
+
+        if (entry)
+        {
+            config.Active = std::string(entry.Version());
+
+            VersionEntry supported;
+            if (auto res = resolution.Find(*config.Detected, false, false) >> supported; !res)
+            {
+                return res;
+            }
+
+            direct = supported && supported.Version() == *config.Active;
+        }
+    }
+
+    resolved.Version = config.Detected;
+    resolved.Resolved = config.Active;
+    resolved.Direct = direct;
+    return {};
+}
@@ -1,7 +1,10 @@
 #include <unvm/semver.hxx>
 #include <unvm/util.hxx>
 
+#include <algorithm>
+#include <charconv>
 #include <iostream>
+#include <limits>
 #include <map>
 #include <sstream>
 
@@ -449,25 +452,49 @@ toolkit::result<unvm::semver::RangeSet> unvm::semver::ParseRangeSet(const std::s
     return ParseRangeSet(stream);
 }
 
-toolkit::result<bool> unvm::semver::IsInRange(const RangeSet &set, const std::string_view version)
+bool unvm::semver::ParseReleaseVersion(std::string_view str, Version &version)
 {
-    const std::string str(version);
-    std::istringstream stream(str);
+    if (str.starts_with('v'))
+    {
+        str.remove_prefix(1);
+    }
 
-    Parser parser(stream);
+    uint32_t *parts[] = { &version.Major, &version.Minor, &version.Patch };
 
-    Version parsed;
-    if (auto res = parser.ParseVersion() >> parsed; !res)
+    auto begin = str.data();
+    const auto end = str.data() + str.size();
+
+    for (auto i = 0; i < 3; ++i)
     {
-        return res;
+        if (i && (begin == end || *begin++ != '.'))
+        {
+            return false;
+        }
+
+        auto [ptr, ec] = std::from_chars(begin, end, *parts[i]);
+        if (ec != std::errc() || ptr == begin)
+        {
+            return false;
+        }
+
+        begin = ptr;
     }
 
-    return IsInRange(set, parsed);
+    version.PreRelease.clear();
+    version.Build.clear();
+    return begin == end;
 }
 
-toolkit::result<bool> unvm::semver::IsInRange(const RangeSet &set, const std::string &version)
+toolkit::result<bool> unvm::semver::IsInRange(const RangeSet &set, const std::string_view version)
 {
-    std::istringstream stream(version);
+    if (Version parsed; ParseReleaseVersion(version, parsed))
+    {
+        return IsInRange(set, parsed);
+    }
+
+    const std::string str(version);
+    std::istringstream stream(str);
+
     Parser parser(stream);
 
     Version parsed;
@@ -479,6 +506,11 @@ toolkit::result<bool> unvm::semver::IsInRange(const RangeSet &set, const std::st
     return IsInRange(set, parsed);
 }
 
+toolkit::result<bool> unvm::semver::IsInRange(const RangeSet &set, const std::string &version)
+{
+    return IsInRange(set, std::string_view(version));
+}
+
 static unvm::semver::Partial normalize_partial(const unvm::semver::Partial &partial)
 {
     return {
@@ -635,6 +667,249 @@ toolkit::result<bool> unvm::semver::IsInRange(const RangeSet &set, const Version
     return false;
 }
 
+static constexpr auto part_bits = 21;
+static constexpr auto part_limit = 1u << part_bits;
+
+static constexpr auto key_infinity = std::numeric_limits<uint64_t>::max();
+
+bool unvm::semver::PackVersion(const uint32_t major, const uint32_t minor, const uint32_t patch, uint64_t &key)
+{
+    if (major >= part_limit || minor >= part_limit || patch >= part_limit)
+    {
+        return false;
+    }
+
+    key = 1ull << 63
+          | static_cast<uint64_t>(major) << part_bits * 2
+          | static_cast<uint64_t>(minor) << part_bits
+          | patch;
+    return true;
+}
+
+bool unvm::semver::PackVersion(const std::string_view version, uint64_t &key)
+{
+    Version parsed;
+    return ParseReleaseVersion(version, parsed) && PackVersion(parsed.Major, parsed.Minor, parsed.Patch, key);
+}
+
+unvm::semver::Version unvm::semver::UnpackVersion(const uint64_t key)
+{
+    constexpr auto mask = part_limit - 1;
+
+    return {
+        .Major = static_cast<uint32_t>(key >> part_bits * 2 & mask),
+        .Minor = static_cast<uint32_t>(key >> part_bits & mask),
+        .Patch = static_cast<uint32_t>(key & mask),
+    };
+}
+
+/**
+ * Pack the first precision + 1 parts of a partial, with wildcards and all following parts as zero. Adding one to the
+ * last packed part yields the first key after every version with the same prefix.
+ */
+[[nodiscard]] static bool pack_partial(
+    const unvm::semver::Partial &partial,
+    const unsigned precision,
+    const uint32_t increment,
+    uint64_t &key)
+{
+    uint32_t parts[3]{};
+
+    for (unsigned i = 0; i <= precision; ++i)
+    {
+        const auto value = i == 0 ? partial.Value.Major : i == 1 ? partial.Value.Minor : partial.Value.Patch;
+        parts[i] = (partial.Mod & 1u << i) ? 0u : value;
+    }
+
+    parts[precision] += increment;
+
+    return unvm::semver::PackVersion(parts[0], parts[1], parts[2], key);
+}
+
+/**
+ * Keys of all versions that compare equal to the partial. Wildcards match anything, so they only stay an interval as
+ * long as no concrete part follows them.
+ */
+[[nodiscard]] static bool compile_equal(const unvm::semver::Partial &partial, unvm::semver::Interval &interval)
+{
+    unsigned precision = 0;
+    for (; precision <= partial.Mask && !(partial.Mod & 1u << precision); ++precision)
+    {
+    }
+
+    for (auto i = precision; i <= partial.Mask; ++i)
+    {
+        if (!(partial.Mod & 1u << i))
+        {
+            return false;
+        }
+    }
+
+    if (!precision)
+    {
+        interval = { 0, key_infinity };
+        return true;
+    }
+
+    return pack_partial(partial, precision - 1, 0, interval.Begin)
+           && pack_partial(partial, precision - 1, 1, interval.End);
+}
+
+[[nodiscard]] static bool compile_primitive(
+    const unvm::semver::Primitive &primitive,
+    unvm::semver::Interval &interval)
+{
+    auto &[type, partial] = primitive;
+
+    if (!partial.Value.PreRelease.empty())
+    {
+        return false;
+    }
+
+    if (type == unvm::semver::PrimitiveType::Equal)
+    {
+        return compile_equal(partial, interval);
+    }
+
+    // comparisons only look at the parts up to the precision of the partial, with wildcards as zero
+    uint64_t lower, upper;
+    if (!pack_partial(partial, partial.Mask, 0, lower) || !pack_partial(partial, partial.Mask, 1, upper))
+    {
+        return false;
+    }
+
+    switch (type)
+    {
+    case unvm::semver::PrimitiveType::LessThan:
+        interval = { 0, lower };
+        return true;
+
+    case unvm::semver::PrimitiveType::LessThanOrEqual:
+        interval = { 0, upper };
+        return true;
+
+    case unvm::semver::PrimitiveType::GreaterThan:
+        interval = { upper, key_infinity };
+        return true;
+
+    case unvm::semver::PrimitiveType::GreaterThanOrEqual:
+        interval = { lower, key_infinity };
+        return true;
+
+    case unvm::semver::PrimitiveType::Tilde:
+    {
+        auto &value = partial.Value;
+
+        interval.Begin = lower;
+        return partial.Mask == 0
+                   ? unvm::semver::PackVersion(value.Major + 1, 0, 0, interval.End)
+                   : unvm::semver::PackVersion(value.Major, value.Minor + 1, 0, interval.End);
+    }
+
+    case unvm::semver::PrimitiveType::Caret:
+    {
+        auto &value = partial.Value;
+
+        interval.Begin = lower;
+        return value.Major > 0
+                   ? unvm::semver::PackVersion(value.Major + 1, 0, 0, interval.End)
+                   : value.Minor > 0
+                   ? unvm::semver::PackVersion(0, value.Minor + 1, 0, interval.End)
+                   : unvm::semver::PackVersion(0, 0, value.Patch + 1, interval.End);
+    }
+
+    default:
+        return false;
+    }
+}
+
+[[nodiscard]] static bool compile_range(const unvm::semver::Range &range, unvm::semver::Interval &interval)
+{
+    if (const auto *hyphen = std::get_if<unvm::semver::Hyphen>(&range))
+    {
+        auto &[begin, end] = *hyphen;
+
+        if (!begin.Value.PreRelease.empty() || !end.Value.PreRelease.empty())
+        {
+            return false;
+        }
+
+        return pack_partial(begin, begin.Mask, 0, interval.Begin) && pack_partial(end, end.Mask, 1, interval.End);
+    }
+
+    interval = { 0, key_infinity };
+
+    for (auto &primitive : std::get<unvm::semver::PrimitiveSet>(range))
+    {
+        unvm::semver::Interval bound;
+        if (!compile_primitive(primitive, bound))
+        {
+            return false;
+        }
+
+        interval.Begin = std::max(interval.Begin, bound.Begin);
+        interval.End = std::min(interval.End, bound.End);
+    }
+
+    return true;
+}
+
+bool unvm::semver::CompileRangeSet(const RangeSet &set, IntervalSet &intervals)
+{
+    intervals.clear();
+
+    for (auto &range : set)
+    {
+        Interval interval;
+        if (!compile_range(range, interval))
+        {
+            return false;
+        }
+
+        if (interval.Begin < interval.End)
+        {
+            intervals.push_back(interval);
+        }
+    }
+
+    std::ranges::sort(
+        intervals,
+        [](const Interval &a, const Interval &b)
+        {
+            return a.Begin < b.Begin;
+        });
+
+    // merge overlapping and adjacent intervals
+    size_t count = 0;
+    for (auto &interval : intervals)
+    {
+        if (count && interval.Begin <= intervals[count - 1].End)
+        {
+            intervals[count - 1].End = std::max(intervals[count - 1].End, interval.End);
+            continue;
+        }
+
+        intervals[count++] = interval;
+    }
+
+    intervals.resize(count);
+    return true;
+}
+
+bool unvm::semver::IsInRange(const IntervalSet &intervals, const uint64_t key)
+{
+    const auto it = std::ranges::upper_bound(
+        intervals,
+        key,
+        {},
+        [](const Interval &interval)
+        {
+            return interval.Begin;
+        });
+
+    return it != intervals.begin() && key < std::prev(it)->End;
+}
+
 bool unvm::semver::operator==(const Partial &a, const Partial &b)
 {
     const auto precision = std::min(a.Mask, b.Mask);
@@ -0,0 +1,169 @@
+#include <unvm/trace.hxx>
+#include <unvm/unvm.hxx>
+#include <unvm/util.hxx>
+
+#include <iostream>
+#include <vector>
+
+#if defined(SYSTEM_LINUX) || defined(SYSTEM_ANDROID) || defined(SYSTEM_DARWIN)
+
+#include <unistd.h>
+
+#endif
+
+#if defined(SYSTEM_WINDOWS)
+
+#include <process.h>
+#include <windows.h>
+
+#endif
+
+#if defined(SYSTEM_WINDOWS)
+
+static int execvp(const char *file, char **argv)
+{
+    std::string line;
+    for (size_t i = 0; argv[i]; ++i)
+    {
+        std::string_view arg = argv[i];
+
+        if (arg.find(' ') != std::string_view::npos)
+        {
+            line += '"';
+            line += arg;
+            line += '"';
+        }
+        else
+        {
+            line += arg;
+        }
+
+        if (argv[i + 1])
+        {
+            line += ' ';
+        }
+    }
+
+    STARTUPINFOA si;
+    PROCESS_INFORMATION pi;
+    ZeroMemory(&si, sizeof(si));
+    ZeroMemory(&pi, sizeof(pi));
+    si.cb = sizeof(si);
+
+    std::vector<char> buf(line.begin(), line.end());
+    buf.push_back(0);
+
+    auto ok = CreateProcessA(nullptr, buf.data(), nullptr, nullptr, false, 0, nullptr, nullptr, &si, &pi);
+
+    if (!ok)
+    {
+        std::cerr << "CreateProcess failed: " << GetLastError() << std::endl;
+        return 1;
+    }
+
+    WaitForSingleObject(pi.hProcess, INFINITE);
+
+    DWORD code = 1;
+    GetExitCodeProcess(pi.hProcess, &code);
+
+    CloseHandle(pi.hThread);
+    CloseHandle(pi.hProcess);
+
+    ExitProcess(code);
+}
+
+#endif
+
+std::filesystem::path unvm::GetNodeExecutable(const std::string_view version)
+{
+#if defined(SYSTEM_LINUX) || defined(SYSTEM_ANDROID) || defined(SYSTEM_DARWIN)
+
+    return GetDataDirectory() / version / "bin" / "node";
+
+#elif defined(SYSTEM_WINDOWS)
+
+    return GetDataDirectory() / version / "node.exe";
+
+#endif
+}
+
+/**
+ * Build the command line that starts the shim target named by the context in the given version, followed by the
+ * arguments of the context.
+ */
+[[nodiscard]] static toolkit::result<std::vector<std::string>> get_command(
+    const std::string_view version,
+    const toolkit::arg_context &context)
+{
+    unvm::TraceSpan span("Shim");
+
+    std::filesystem::path exec(context.file);
+
+    const auto data_directory = unvm::GetDataDirectory();
+    const auto node_path = unvm::GetNodeExecutable(version);
+
+#if defined(SYSTEM_LINUX) || defined(SYSTEM_ANDROID) || defined(SYSTEM_DARWIN)
+
+    const auto npm_cli_path = data_directory / version / "lib" / "node_modules" / "npm" / "bin" / "npm-cli.js";
+    const auto npx_cli_path = data_directory / version / "lib" / "node_modules" / "npm" / "bin" / "npx-cli.js";
+
+#elif defined(SYSTEM_WINDOWS)
+
+    const auto npm_cli_path = data_directory / version / "node_modules" / "npm" / "bin" / "npm-cli.js";
+    const auto npx_cli_path = data_directory / version / "node_modules" / "npm" / "bin" / "npx-cli.js";
+
+#endif
+
+    std::vector<std::string> command;
+    command.push_back(node_path.string());
+
+    const auto stem = exec.stem().string();
+
+    if (stem == "node")
+    {
+    }
+    else if (stem == "npm")
+    {
+        command.push_back(npm_cli_path.string());
+    }
+    else if (stem == "npx")
+    {
+        command.push_back(npx_cli_path.string());
+    }
+    else
+    {
+        return toolkit::make_error("unsupported shim target '{}'.", stem);
+    }
+
+    for (size_t i = 0; i < context.size(); ++i)
+    {
+        command.emplace_back(context[i]);
+    }
+
+    return command;
+}
+
+toolkit::result<> unvm::Shim(const std::string_view version, const toolkit::arg_context &context)
+{
+    std::vector<std::string> command;
+    if (auto res = get_command(version, context) >> command; !res)
+    {
+        return res;
+    }
+
+    std::vector<char *> args;
+    for (auto &arg : command)
+    {
+        args.push_back(arg.data());
+    }
+
+    args.push_back(nullptr);
+
+    // the process image is replaced below, so nothing would be written at exit. the span of building the command is
+    // closed by now, the spans of the callers are written as ending here
+    FlushTrace();
+
+    const auto error = execvp(args[0], args.data());
+
+    return toolkit::make_error("failed to execute '{}': {}", command[0], error);
+}
@@ -0,0 +1,191 @@
+#include <unvm/trace.hxx>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(SYSTEM_WINDOWS)
+
+#include <process.h>
+
+#define getpid _getpid
+
+#else
+
+#include <unistd.h>
+
+#endif
+
+struct TraceEvent
+{
+    const char *Name;
+    int64_t Begin;
+    int64_t End;
+    size_t Thread;
+};
+
+/**
+ * A span that began but did not end yet, identified by its address.
+ */
+struct OpenTraceSpan
+{
+    const unvm::TraceSpan *Span;
+    TraceEvent Event;
+};
+
+/**
+ * Nanoseconds on the monotonic clock, which is shared across processes, so traces of a shim and the processes it
+ * starts line up.
+ */
+static int64_t get_trace_time()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// constructed before the flag below registers the exit handler, so the handler runs before they are destroyed
+static std::mutex trace_mutex;
+static std::vector<TraceEvent> trace_events;
+static std::vector<OpenTraceSpan> trace_open;
+static std::filesystem::path trace_directory;
+static std::string trace_file;
+
+static bool init_trace()
+{
+    const auto directory = std::getenv("UNVM_TRACE");
+    if (!directory || !*directory)
+    {
+        return false;
+    }
+
+    trace_directory = directory;
+
+    // unvm-shim passes launches on to unvm with execv, which keeps the pid, so the pid alone does not tell the two
+    // process images apart
+    trace_file = std::format("unvm-{}-{}.json", getpid(), get_trace_time());
+
+    std::atexit(unvm::FlushTrace);
+    return true;
+}
+
+const bool unvm::TraceEnabled = init_trace();
+
+static void write_trace_time(std::ostream &stream, const int64_t nanoseconds)
+{
+    // trace-event timestamps are microseconds, the fraction keeps nanosecond precision
+    stream << nanoseconds / 1000 << '.';
+
+    const auto fraction = std::to_string(nanoseconds % 1000);
+    stream << std::string(3 - fraction.size(), '0') << fraction;
+}
+
+void unvm::TraceSpan::Begin(const char *name)
+{
+    m_Name = name;
+
+    const OpenTraceSpan open
+    {
+        .Span = this,
+        .Event =
+        {
+            .Name = name,
+            .Begin = get_trace_time(),
+            .End = 0,
+            .Thread = std::hash<std::thread::id>()(std::this_thread::get_id()),
+        },
+    };
+
+    std::lock_guard lock(trace_mutex);
+    trace_open.push_back(open);
+}
+
+void unvm::TraceSpan::End()
+{
+    const auto end = get_trace_time();
+
+    std::lock_guard lock(trace_mutex);
+
+    // spans mostly end in reverse order, so the search rarely goes past the last one
+    const auto it = std::find_if(
+        trace_open.rbegin(),
+        trace_open.rend(),
+        [this](const OpenTraceSpan &open)
+        {
+            return open.Span == this;
+        });
+
+    if (it == trace_open.rend())
+    {
+        return;
+    }
+
+    auto event = it->Event;
+    event.End = end;
+
+    trace_events.push_back(event);
+    trace_open.erase(std::next(it).base());
+}
+
+void unvm::FlushTrace()
+{
+    if (!TraceEnabled)
+    {
+        return;
+    }
+
+    const auto now = get_trace_time();
+
+    std::lock_guard lock(trace_mutex);
+
+    // the outer phases are still open when the process is replaced, so they are cut off here, and whatever remains of
+    // them is recorded from here on, should the process go on
+    for (auto &[span, event] : trace_open)
+    {
+        auto cut = event;
+        cut.End = now;
+
+        trace_events.push_back(cut);
+        event.Begin = now;
+    }
+
+    if (trace_events.empty())
+    {
+        return;
+    }
+
+    const auto pid = getpid();
+
+    std::error_code ec;
+    std::filesystem::create_directories(trace_directory, ec);
+
+    // all events are written every time, so a flush at exit after a failed exec does not lose the earlier ones
+    std::ofstream stream(trace_directory / trace_file);
+    if (!stream)
+    {
+        return;
+    }
+
+    stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+
+    for (size_t i = 0; i < trace_events.size(); ++i)
+    {
+        auto &[name, begin, end, thread] = trace_events[i];
+
+        stream << (i ? ",\n" : "\n");
+        stream << "{\"name\":\"" << name << "\",\"cat\":\"unvm\",\"ph\":\"X\",\"ts\":";
+        write_trace_time(stream, begin);
+        stream << ",\"dur\":";
+        write_trace_time(stream, end - begin);
+        stream << ",\"pid\":" << pid << ",\"tid\":" << thread << '}';
+    }
+
+    stream << "\n]}" << std::endl;
+}
@@ -1,3 +1,4 @@
+#include <unvm/trace.hxx>
 #include <unvm/unvm.hxx>
 
 #include <toolkit/defer.hxx>
@@ -28,6 +29,8 @@ static la_ssize_t read_callback(archive */*arc*/, void *user_data, const void **
 
 toolkit::result<> unvm::UnpackArchive(std::istream &stream, const std::filesystem::path &directory)
 {
+    TraceSpan span("UnpackArchive");
+
     const auto arc = archive_read_new();
     const auto ext = archive_write_disk_new();
 
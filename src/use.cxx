@@ -3,14 +3,18 @@
 
 #include <iostream>
 
-toolkit::result<> unvm::Use(Config &config, http::HttpClient &client, const std::string_view version, const bool local)
+toolkit::result<> unvm::Use(
+    Config &config,
+    ResolutionContext &resolution,
+    const std::string_view version,
+    const bool local)
 {
     std::optional<std::string> maybe_active;
     VersionType type;
 
     if (local)
     {
-        if (auto res = FindActiveVersion(config.Default, &type) >> maybe_active; !res)
+        if (auto res = resolution.ActiveVersion(&type) >> maybe_active; !res)
         {
             return toolkit::make_error("failed to find active version: {}", res.error());
         }
@@ -53,16 +57,8 @@ toolkit::result<> unvm::Use(Config &config, http::HttpClient &client, const std:
         return {};
     }
 
-    VersionTable table;
-    if (auto res = LoadVersionTable(client, table, false); !res)
-    {
-        return res;
-    }
-
-    FilterVersionTable(config, table, true, true);
-
-    const VersionEntry *entry{};
-    if (auto res = FindVersionEntry(table, version) >> entry; !res)
+    VersionEntry entry;
+    if (auto res = resolution.Find(version, false, true) >> entry; !res)
     {
         return res;
     }
@@ -72,7 +68,9 @@ toolkit::result<> unvm::Use(Config &config, http::HttpClient &client, const std:
         return toolkit::make_error("version '{}' is not installed.", version);
     }
 
-    if (maybe_active && *maybe_active == entry->Version)
+    const std::string entry_version(entry.Version());
+
+    if (maybe_active && *maybe_active == entry_version)
     {
         std::cerr << "version '" << version << "' is already active in the current context." << std::endl;
         return {};
@@ -80,12 +78,12 @@ toolkit::result<> unvm::Use(Config &config, http::HttpClient &client, const std:
 
     if (!local)
     {
-        config.Default = entry->Version;
+        config.Default = entry_version;
         config.UpdatedDefault = true;
         return {};
     }
 
-    if (auto res = WriteVersionFile(entry->Version); !res)
+    if (auto res = WriteVersionFile(entry_version); !res)
     {
         return toolkit::make_error("failed to write version file: {}", res.error());
     }
@@ -1,3 +1,4 @@
+#include <unvm/scanner.hxx>
 #include <unvm/util.hxx>
 
 #include <fstream>
@@ -5,22 +6,23 @@
 
 bool unvm::FindVersionFile(std::filesystem::path &path)
 {
-    for (auto parent_path = std::filesystem::weakly_canonical(std::filesystem::current_path());;)
+    MarkerScanner scanner;
+    if (!(MarkerScanner::Open() >> scanner))
     {
-        if (auto entry = parent_path / ".unvm"; std::filesystem::exists(entry))
-        {
-            path = std::move(entry);
-            return true;
-        }
+        return false;
+    }
 
-        auto next = parent_path.parent_path();
-        if (next == parent_path)
+    do
+    {
+        if (scanner.Find(VersionFileName))
         {
-            return false;
+            path = scanner.Path(VersionFileName);
+            return true;
         }
-
-        parent_path = next;
     }
+    while (scanner.Up());
+
+    return false;
 }
 
 toolkit::result<> unvm::ReadVersionFile(std::optional<std::string> &version)
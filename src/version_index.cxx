@@ -0,0 +1,353 @@
+#include <unvm/index.hxx>
+#include <unvm/util.hxx>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#if defined(SYSTEM_WINDOWS)
+
+#define NOMINMAX
+
+#include <process.h>
+#include <windows.h>
+
+#define getpid _getpid
+
+#else
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#endif
+
+static constexpr char magic[4]{ 'U', 'N', 'V', 'I' };
+
+/**
+ * Take the next column of count values of type T from the mapping. Every column size is a multiple of the alignment
+ * of the columns following it, so they stay aligned.
+ */
+template<typename T>
+static std::span<const T> take_column(const char *&base, const size_t count)
+{
+    const std::span column(reinterpret_cast<const T *>(base), count);
+    base += count * sizeof(T);
+    return column;
+}
+
+/**
+ * Write the value get returns for each row as one column.
+ */
+template<typename T, typename F>
+static void write_column(std::ostream &stream, const std::vector<unvm::VersionTable::Row> &rows, F &&get)
+{
+    std::vector<T> column;
+    column.reserve(rows.size());
+
+    for (auto &row : rows)
+    {
+        column.push_back(static_cast<T>(get(row)));
+    }
+
+    stream.write(
+        reinterpret_cast<const char *>(column.data()),
+        static_cast<std::streamsize>(column.size() * sizeof(T)));
+}
+
+bool unvm::VersionIndex::GetSourceStamp(const std::filesystem::path &path, SourceStamp &stamp)
+{
+    std::error_code ec;
+
+    stamp.Size = std::filesystem::file_size(path, ec);
+    if (ec)
+    {
+        return false;
+    }
+
+    stamp.Time = std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+    return !ec;
+}
+
+toolkit::result<unvm::VersionIndex> unvm::VersionIndex::Open(
+    const std::filesystem::path &path,
+    const std::filesystem::path &source_path)
+{
+    SourceStamp source;
+    if (!GetSourceStamp(source_path, source))
+    {
+        return toolkit::make_error("failed to stat '{}'.", source_path.string());
+    }
+
+    VersionIndex index;
+
+#if defined(SYSTEM_WINDOWS)
+
+    const auto file = CreateFileW(
+        path.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ | FILE_SHARE_DELETE,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return toolkit::make_error("failed to open '{}'.", path.string());
+    }
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart < static_cast<LONGLONG>(sizeof(Header)))
+    {
+        CloseHandle(file);
+        return toolkit::make_error("invalid version index '{}'.", path.string());
+    }
+
+    index.m_Mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+
+    if (!index.m_Mapping)
+    {
+        return toolkit::make_error("failed to map '{}'.", path.string());
+    }
+
+    index.m_Data = MapViewOfFile(index.m_Mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!index.m_Data)
+    {
+        return toolkit::make_error("failed to map '{}'.", path.string());
+    }
+
+    index.m_Size = static_cast<size_t>(file_size.QuadPart);
+
+#else
+
+    const auto path_string = path.string();
+
+    const auto fd = open(path_string.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return toolkit::make_error("failed to open '{}'.", path_string);
+    }
+
+    struct stat st{};
+    if (fstat(fd, &st) || st.st_size < static_cast<off_t>(sizeof(Header)))
+    {
+        close(fd);
+        return toolkit::make_error("invalid version index '{}'.", path_string);
+    }
+
+    const auto data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED)
+    {
+        return toolkit::make_error("failed to map '{}'.", path_string);
+    }
+
+    index.m_Data = data;
+    index.m_Size = st.st_size;
+
+#endif
+
+    const auto base = static_cast<const char *>(index.m_Data);
+    const auto header = reinterpret_cast<const Header *>(base);
+
+    if (std::memcmp(header->Magic, magic, sizeof(magic)) || header->Revision != Revision)
+    {
+        return toolkit::make_error("invalid version index '{}'.", path.string());
+    }
+
+    const auto count = static_cast<size_t>(header->Count);
+    if (index.m_Size != sizeof(Header) + count * RowSize + header->PoolSize
+        || !header->PoolSize
+        || base[index.m_Size - 1] != '\0')
+    {
+        return toolkit::make_error("invalid version index '{}'.", path.string());
+    }
+
+    if (header->SourceSize != source.Size || header->SourceTime != source.Time)
+    {
+        return toolkit::make_error("version index '{}' is stale.", path.string());
+    }
+
+    auto column = base + sizeof(Header);
+
+    index.m_Header = header;
+    index.m_Columns.Key = take_column<uint64_t>(column, count);
+    index.m_Columns.Version = take_column<uint32_t>(column, count);
+    index.m_Columns.Date = take_column<uint32_t>(column, count);
+    index.m_Columns.Files = take_column<uint32_t>(column, count);
+    index.m_Columns.NPM = take_column<uint32_t>(column, count);
+    index.m_Columns.V8 = take_column<uint32_t>(column, count);
+    index.m_Columns.UV = take_column<uint32_t>(column, count);
+    index.m_Columns.ZLib = take_column<uint32_t>(column, count);
+    index.m_Columns.OpenSSL = take_column<uint32_t>(column, count);
+    index.m_Columns.LTS = take_column<uint32_t>(column, count);
+    index.m_Columns.Modules = take_column<uint16_t>(column, count);
+    index.m_Columns.Security = take_column<uint8_t>(column, count);
+    index.m_Columns.Pool = { column, header->PoolSize };
+
+    return index;
+}
+
+toolkit::result<> unvm::VersionIndex::Write(
+    const std::filesystem::path &path,
+    const SourceStamp &source,
+    const VersionTable &table)
+{
+    Header header{};
+    std::memcpy(header.Magic, magic, sizeof(magic));
+    header.Revision = Revision;
+    header.SourceSize = source.Size;
+    header.SourceTime = source.Time;
+
+    std::vector<VersionTable::Row> rows;
+    std::string pool(table.Pool());
+
+    constexpr auto mask = GetPlatformFileMask(platform.Pattern);
+
+    for (size_t i = 0; i < table.Size(); ++i)
+    {
+        if (auto row = table.Raw(i); row.Files & mask)
+        {
+            rows.push_back(row);
+        }
+    }
+
+    if (pool.empty())
+    {
+        pool.push_back('\0');
+    }
+
+    header.Count = static_cast<uint32_t>(rows.size());
+    header.PoolSize = static_cast<uint32_t>(pool.size());
+
+    // readers rebuild the index without holding any lock, so each writer needs a temp file of its own
+    auto temp_path = path;
+    temp_path += std::format(".{}", getpid());
+
+    {
+        std::ofstream stream(temp_path, std::ios::binary | std::ios::trunc);
+        if (!stream)
+        {
+            return toolkit::make_error("failed to open '{}'.", temp_path.string());
+        }
+
+        using Row = VersionTable::Row;
+
+        stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        write_column<uint64_t>(stream, rows, [](const Row &row) { return row.Key; });
+        write_column<uint32_t>(stream, rows, [](const Row &row) { return row.Version; });
+        write_column<uint32_t>(stream, rows, [](const Row &row) { return row.Date; });
+        write_column<uint32_t>(stream, rows, [](const Row &row) { return row.Files; });
+        write_column<uint32_t>(stream, rows, [](const Row &row) { return row.NPM; });
+        write_column<uint32_t>(stream, rows, [](const Row &row) { return row.V8; });
+        write_column<uint32_t>(stream, rows, [](const Row &row) { return row.UV; });
+        write_column<uint32_t>(stream, rows, [](const Row &row) { return row.ZLib; });
+        write_column<uint32_t>(stream, rows, [](const Row &row) { return row.OpenSSL; });
+        write_column<uint32_t>(stream, rows, [](const Row &row) { return row.LTS; });
+        write_column<uint16_t>(stream, rows, [](const Row &row) { return row.Modules; });
+        write_column<uint8_t>(stream, rows, [](const Row &row) { return row.Security; });
+        stream.write(pool.data(), static_cast<std::streamsize>(pool.size()));
+
+        if (!stream)
+        {
+            return toolkit::make_error("failed to write '{}'.", temp_path.string());
+        }
+    }
+
+    if (std::error_code ec; RenameFile(temp_path, path, ec), ec)
+    {
+        std::error_code remove_ec;
+        std::filesystem::remove(temp_path, remove_ec);
+
+        return toolkit::make_error("failed to rename version index: {} ({}).", ec.message(), ec.value());
+    }
+
+    return {};
+}
+
+unvm::VersionIndex::~VersionIndex()
+{
+#if defined(SYSTEM_WINDOWS)
+
+    if (m_Data)
+    {
+        UnmapViewOfFile(m_Data);
+    }
+
+    if (m_Mapping)
+    {
+        CloseHandle(m_Mapping);
+    }
+
+#else
+
+    if (m_Data)
+    {
+        munmap(const_cast<void *>(m_Data), m_Size);
+    }
+
+#endif
+}
+
+unvm::VersionIndex::VersionIndex(VersionIndex &&other) noexcept
+{
+    *this = std::move(other);
+}
+
+unvm::VersionIndex &unvm::VersionIndex::operator=(VersionIndex &&other) noexcept
+{
+    std::swap(m_Header, other.m_Header);
+    std::swap(m_Columns, other.m_Columns);
+    std::swap(m_Data, other.m_Data);
+    std::swap(m_Size, other.m_Size);
+
+#if defined(SYSTEM_WINDOWS)
+
+    std::swap(m_Mapping, other.m_Mapping);
+
+#endif
+
+    return *this;
+}
+
+size_t unvm::VersionIndex::Size() const
+{
+    return m_Header ? m_Header->Count : 0;
+}
+
+bool unvm::VersionIndex::Read(VersionTable &table) &&
+{
+    const auto pool_size = m_Columns.Pool.size();
+
+    auto valid = [pool_size](const uint32_t offset)
+    {
+        return offset == NoString || offset < pool_size;
+    };
+
+    auto valid_column = [&valid](const std::span<const uint32_t> column)
+    {
+        return std::ranges::all_of(column, valid);
+    };
+
+    table.Clear();
+
+    if (std::ranges::find(m_Columns.Version, NoString) != m_Columns.Version.end()
+        || !valid_column(m_Columns.Version)
+        || !valid_column(m_Columns.NPM)
+        || !valid_column(m_Columns.V8)
+        || !valid_column(m_Columns.UV)
+        || !valid_column(m_Columns.ZLib)
+        || !valid_column(m_Columns.OpenSSL)
+        || !valid_column(m_Columns.LTS))
+    {
+        return false;
+    }
+
+    const auto columns = m_Columns;
+    table.Attach(columns, std::make_shared<VersionIndex>(std::move(*this)));
+    return true;
+}
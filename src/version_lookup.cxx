@@ -0,0 +1,131 @@
+#include <unvm/lookup.hxx>
+#include <unvm/semver.hxx>
+
+static char fold(const char c)
+{
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+static uint64_t bucket_key(const uint32_t major, const uint32_t minor = {})
+{
+    uint64_t key{};
+    (void) unvm::semver::PackVersion(major, minor, 0, key);
+    return key;
+}
+
+size_t unvm::VersionLookup::FoldHash::operator()(const std::string_view value) const
+{
+    // fnv-1a over the folded characters
+    uint64_t hash = 14695981039346656037ull;
+    for (const auto c : value)
+    {
+        hash ^= static_cast<unsigned char>(fold(c));
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+bool unvm::VersionLookup::FoldEqual::operator()(const std::string_view a, const std::string_view b) const
+{
+    if (a.size() != b.size())
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        if (fold(a[i]) != fold(b[i]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+unvm::VersionLookup::VersionLookup(const VersionView &view)
+{
+    auto &table = view.Table();
+
+    auto newer = [&table](const uint32_t index, const uint32_t other)
+    {
+        return other == None || table.Key(index) > table.Key(other);
+    };
+
+    auto insert = [&newer](auto &bucket, const auto &key, const uint32_t index)
+    {
+        if (auto [it, inserted] = bucket.try_emplace(key, index); !inserted && newer(index, it->second))
+        {
+            it->second = index;
+        }
+    };
+
+    m_Exact.reserve(view.Size());
+
+    for (const auto i : view.Rows())
+    {
+        const auto key = table.Key(i);
+        if (!key)
+        {
+            continue;
+        }
+
+        const auto version = semver::UnpackVersion(key);
+
+        insert(m_Majors, bucket_key(version.Major), i);
+        insert(m_Minors, bucket_key(version.Major, version.Minor), i);
+        insert(m_Exact, key, i);
+
+        if (newer(i, m_Latest))
+        {
+            m_Latest = i;
+        }
+
+        const auto lts = table.LTS(i);
+        if (!lts)
+        {
+            continue;
+        }
+
+        if (newer(i, m_LatestLTS))
+        {
+            m_LatestLTS = i;
+        }
+
+        insert(m_Codenames, *lts, i);
+    }
+}
+
+uint32_t unvm::VersionLookup::Latest() const
+{
+    return m_Latest;
+}
+
+uint32_t unvm::VersionLookup::LatestLTS() const
+{
+    return m_LatestLTS;
+}
+
+uint32_t unvm::VersionLookup::Major(const uint32_t major) const
+{
+    const auto it = m_Majors.find(bucket_key(major));
+    return it != m_Majors.end() ? it->second : None;
+}
+
+uint32_t unvm::VersionLookup::Minor(const uint32_t major, const uint32_t minor) const
+{
+    const auto it = m_Minors.find(bucket_key(major, minor));
+    return it != m_Minors.end() ? it->second : None;
+}
+
+uint32_t unvm::VersionLookup::Exact(const uint64_t key) const
+{
+    const auto it = m_Exact.find(key);
+    return it != m_Exact.end() ? it->second : None;
+}
+
+uint32_t unvm::VersionLookup::Codename(const std::string_view name) const
+{
+    const auto it = m_Codenames.find(name);
+    return it != m_Codenames.end() ? it->second : None;
+}
@@ -0,0 +1,501 @@
+#include <unvm/semver.hxx>
+#include <unvm/version.hxx>
+
+#include <algorithm>
+#include <charconv>
+#include <numeric>
+
+/**
+ * Parse a 'yyyy-mm-dd' date into yyyymmdd, or zero if it does not have that form.
+ */
+static uint32_t parse_date(const std::string_view str)
+{
+    uint32_t parts[3];
+
+    auto begin = str.data();
+    const auto end = str.data() + str.size();
+
+    for (auto i = 0; i < 3; ++i)
+    {
+        if (i && (begin == end || *begin++ != '-'))
+        {
+            return 0;
+        }
+
+        auto [ptr, ec] = std::from_chars(begin, end, parts[i]);
+        if (ec != std::errc() || ptr == begin)
+        {
+            return 0;
+        }
+
+        begin = ptr;
+    }
+
+    if (begin != end || parts[1] > 12 || parts[2] > 31)
+    {
+        return 0;
+    }
+
+    return parts[0] * 10000 + parts[1] * 100 + parts[2];
+}
+
+template<typename T>
+static void reorder(std::vector<T> &column, const std::vector<uint32_t> &order)
+{
+    std::vector<T> result;
+    result.reserve(order.size());
+
+    for (const auto index : order)
+    {
+        result.push_back(column[index]);
+    }
+
+    column = std::move(result);
+}
+
+unvm::VersionEntry::VersionEntry(const VersionTable *table, const uint32_t index)
+    : m_Table(table),
+      m_Index(index)
+{
+}
+
+unvm::VersionEntry::operator bool() const
+{
+    return m_Table;
+}
+
+const unvm::VersionTable &unvm::VersionEntry::Table() const
+{
+    return *m_Table;
+}
+
+uint32_t unvm::VersionEntry::Index() const
+{
+    return m_Index;
+}
+
+uint64_t unvm::VersionEntry::Key() const
+{
+    return m_Table->Key(m_Index);
+}
+
+std::string_view unvm::VersionEntry::Version() const
+{
+    return m_Table->Version(m_Index);
+}
+
+uint32_t unvm::VersionEntry::Date() const
+{
+    return m_Table->Date(m_Index);
+}
+
+uint32_t unvm::VersionEntry::Files() const
+{
+    return m_Table->Files(m_Index);
+}
+
+std::optional<std::string_view> unvm::VersionEntry::NPM() const
+{
+    return m_Table->NPM(m_Index);
+}
+
+std::string_view unvm::VersionEntry::V8() const
+{
+    return m_Table->V8(m_Index);
+}
+
+std::optional<std::string_view> unvm::VersionEntry::UV() const
+{
+    return m_Table->UV(m_Index);
+}
+
+std::optional<std::string_view> unvm::VersionEntry::ZLib() const
+{
+    return m_Table->ZLib(m_Index);
+}
+
+std::optional<std::string_view> unvm::VersionEntry::OpenSSL() const
+{
+    return m_Table->OpenSSL(m_Index);
+}
+
+uint16_t unvm::VersionEntry::Modules() const
+{
+    return m_Table->Modules(m_Index);
+}
+
+std::optional<std::string_view> unvm::VersionEntry::LTS() const
+{
+    return m_Table->LTS(m_Index);
+}
+
+bool unvm::VersionEntry::Security() const
+{
+    return m_Table->Security(m_Index);
+}
+
+unvm::VersionTable::Iterator::Iterator(const VersionTable *table, const uint32_t index)
+    : m_Table(table),
+      m_Index(index)
+{
+}
+
+unvm::VersionEntry unvm::VersionTable::Iterator::operator*() const
+{
+    return { m_Table, m_Index };
+}
+
+unvm::VersionTable::Iterator &unvm::VersionTable::Iterator::operator++()
+{
+    ++m_Index;
+    return *this;
+}
+
+unvm::VersionTable::Iterator unvm::VersionTable::Iterator::operator++(int)
+{
+    auto copy = *this;
+    ++m_Index;
+    return copy;
+}
+
+size_t unvm::VersionTable::Size() const
+{
+    return m_Columns.Key.size();
+}
+
+bool unvm::VersionTable::Empty() const
+{
+    return m_Columns.Key.empty();
+}
+
+unvm::VersionEntry unvm::VersionTable::operator[](const size_t index) const
+{
+    return { this, static_cast<uint32_t>(index) };
+}
+
+unvm::VersionTable::Iterator unvm::VersionTable::begin() const
+{
+    return { this, 0 };
+}
+
+unvm::VersionTable::Iterator unvm::VersionTable::end() const
+{
+    return { this, static_cast<uint32_t>(Size()) };
+}
+
+std::span<const uint64_t> unvm::VersionTable::Keys() const
+{
+    return m_Columns.Key;
+}
+
+std::string_view unvm::VersionTable::Pool() const
+{
+    return m_Columns.Pool;
+}
+
+unvm::VersionTable::Row unvm::VersionTable::Raw(const size_t index) const
+{
+    return {
+        .Key = m_Columns.Key[index],
+        .Version = m_Columns.Version[index],
+        .Date = m_Columns.Date[index],
+        .Files = m_Columns.Files[index],
+        .NPM = m_Columns.NPM[index],
+        .V8 = m_Columns.V8[index],
+        .UV = m_Columns.UV[index],
+        .ZLib = m_Columns.ZLib[index],
+        .OpenSSL = m_Columns.OpenSSL[index],
+        .LTS = m_Columns.LTS[index],
+        .Modules = m_Columns.Modules[index],
+        .Security = static_cast<bool>(m_Columns.Security[index]),
+    };
+}
+
+uint64_t unvm::VersionTable::Key(const size_t index) const
+{
+    return m_Columns.Key[index];
+}
+
+std::string_view unvm::VersionTable::Version(const size_t index) const
+{
+    return String(m_Columns.Version[index]);
+}
+
+uint32_t unvm::VersionTable::Date(const size_t index) const
+{
+    return m_Columns.Date[index];
+}
+
+uint32_t unvm::VersionTable::Files(const size_t index) const
+{
+    return m_Columns.Files[index];
+}
+
+std::optional<std::string_view> unvm::VersionTable::NPM(const size_t index) const
+{
+    return OptionalString(m_Columns.NPM[index]);
+}
+
+std::string_view unvm::VersionTable::V8(const size_t index) const
+{
+    return String(m_Columns.V8[index]);
+}
+
+std::optional<std::string_view> unvm::VersionTable::UV(const size_t index) const
+{
+    return OptionalString(m_Columns.UV[index]);
+}
+
+std::optional<std::string_view> unvm::VersionTable::ZLib(const size_t index) const
+{
+    return OptionalString(m_Columns.ZLib[index]);
+}
+
+std::optional<std::string_view> unvm::VersionTable::OpenSSL(const size_t index) const
+{
+    return OptionalString(m_Columns.OpenSSL[index]);
+}
+
+uint16_t unvm::VersionTable::Modules(const size_t index) const
+{
+    return m_Columns.Modules[index];
+}
+
+std::optional<std::string_view> unvm::VersionTable::LTS(const size_t index) const
+{
+    return OptionalString(m_Columns.LTS[index]);
+}
+
+bool unvm::VersionTable::Security(const size_t index) const
+{
+    return m_Columns.Security[index];
+}
+
+void unvm::VersionTable::Clear()
+{
+    m_Key.clear();
+    m_Version.clear();
+    m_Date.clear();
+    m_Files.clear();
+    m_NPM.clear();
+    m_V8.clear();
+    m_UV.clear();
+    m_ZLib.clear();
+    m_OpenSSL.clear();
+    m_LTS.clear();
+    m_Modules.clear();
+    m_Security.clear();
+
+    m_Pool.clear();
+    m_Interned.clear();
+
+    m_Backing.reset();
+    Sync();
+}
+
+void unvm::VersionTable::Reserve(const size_t count)
+{
+    Own();
+
+    m_Key.reserve(count);
+    m_Version.reserve(count);
+    m_Date.reserve(count);
+    m_Files.reserve(count);
+    m_NPM.reserve(count);
+    m_V8.reserve(count);
+    m_UV.reserve(count);
+    m_ZLib.reserve(count);
+    m_OpenSSL.reserve(count);
+    m_LTS.reserve(count);
+    m_Modules.reserve(count);
+    m_Security.reserve(count);
+
+    Sync();
+}
+
+void unvm::VersionTable::Attach(const Columns &columns, std::shared_ptr<const void> backing)
+{
+    Clear();
+
+    m_Columns = columns;
+    m_Backing = std::move(backing);
+}
+
+void unvm::VersionTable::Append(const VersionInfo &info)
+{
+    Own();
+
+    Row row
+    {
+        .Version = Intern(info.Version),
+        .Date = parse_date(info.Date),
+        .NPM = InternOptional(info.NPM),
+        .V8 = Intern(info.V8),
+        .UV = InternOptional(info.UV),
+        .ZLib = InternOptional(info.ZLib),
+        .OpenSSL = InternOptional(info.OpenSSL),
+        .LTS = InternOptional(info.LTS),
+        .Modules = info.Modules,
+        .Security = info.Security,
+    };
+
+    if (!semver::PackVersion(info.Version, row.Key))
+    {
+        row.Key = 0;
+    }
+
+    for (auto &file : info.Files)
+    {
+        row.Files |= GetPlatformFileMask(file);
+    }
+
+    Append(row);
+}
+
+void unvm::VersionTable::Append(const Row &row)
+{
+    Own();
+
+    m_Key.push_back(row.Key);
+    m_Version.push_back(row.Version);
+    m_Date.push_back(row.Date);
+    m_Files.push_back(row.Files);
+    m_NPM.push_back(row.NPM);
+    m_V8.push_back(row.V8);
+    m_UV.push_back(row.UV);
+    m_ZLib.push_back(row.ZLib);
+    m_OpenSSL.push_back(row.OpenSSL);
+    m_LTS.push_back(row.LTS);
+    m_Modules.push_back(row.Modules);
+    m_Security.push_back(row.Security);
+
+    Sync();
+}
+
+void unvm::VersionTable::Sort()
+{
+    Own();
+
+    std::vector<uint32_t> order(Size());
+    std::iota(order.begin(), order.end(), 0u);
+
+    std::ranges::stable_sort(
+        order,
+        [this](const uint32_t a, const uint32_t b)
+        {
+            return m_Key[a] > m_Key[b];
+        });
+
+    Reorder(order);
+    Sync();
+}
+
+std::string_view unvm::VersionTable::String(const uint32_t offset) const
+{
+    if (offset == NoString || offset >= m_Columns.Pool.size())
+    {
+        return {};
+    }
+
+    return m_Columns.Pool.data() + offset;
+}
+
+std::optional<std::string_view> unvm::VersionTable::OptionalString(const uint32_t offset) const
+{
+    if (offset == NoString)
+    {
+        return std::nullopt;
+    }
+
+    return String(offset);
+}
+
+uint32_t unvm::VersionTable::Intern(const std::string_view value)
+{
+    // keyed by hash only, so growing the pool never invalidates the keys
+    const auto hash = std::hash<std::string_view>()(value);
+
+    for (auto [it, end] = m_Interned.equal_range(hash); it != end; ++it)
+    {
+        if (String(it->second) == value)
+        {
+            return it->second;
+        }
+    }
+
+    const auto offset = static_cast<uint32_t>(m_Pool.size());
+    m_Pool.append(value);
+    m_Pool.push_back('\0');
+    m_Columns.Pool = m_Pool;
+
+    m_Interned.emplace(hash, offset);
+    return offset;
+}
+
+uint32_t unvm::VersionTable::InternOptional(const std::optional<std::string> &value)
+{
+    return value ? Intern(*value) : NoString;
+}
+
+void unvm::VersionTable::Reorder(const std::vector<uint32_t> &order)
+{
+    reorder(m_Key, order);
+    reorder(m_Version, order);
+    reorder(m_Date, order);
+    reorder(m_Files, order);
+    reorder(m_NPM, order);
+    reorder(m_V8, order);
+    reorder(m_UV, order);
+    reorder(m_ZLib, order);
+    reorder(m_OpenSSL, order);
+    reorder(m_LTS, order);
+    reorder(m_Modules, order);
+    reorder(m_Security, order);
+}
+
+void unvm::VersionTable::Own()
+{
+    if (!m_Backing)
+    {
+        return;
+    }
+
+    m_Key.assign(m_Columns.Key.begin(), m_Columns.Key.end());
+    m_Version.assign(m_Columns.Version.begin(), m_Columns.Version.end());
+    m_Date.assign(m_Columns.Date.begin(), m_Columns.Date.end());
+    m_Files.assign(m_Columns.Files.begin(), m_Columns.Files.end());
+    m_NPM.assign(m_Columns.NPM.begin(), m_Columns.NPM.end());
+    m_V8.assign(m_Columns.V8.begin(), m_Columns.V8.end());
+    m_UV.assign(m_Columns.UV.begin(), m_Columns.UV.end());
+    m_ZLib.assign(m_Columns.ZLib.begin(), m_Columns.ZLib.end());
+    m_OpenSSL.assign(m_Columns.OpenSSL.begin(), m_Columns.OpenSSL.end());
+    m_LTS.assign(m_Columns.LTS.begin(), m_Columns.LTS.end());
+    m_Modules.assign(m_Columns.Modules.begin(), m_Columns.Modules.end());
+    m_Security.assign(m_Columns.Security.begin(), m_Columns.Security.end());
+
+    // the attached pool was not interned, so strings appended later are not deduplicated against it
+    m_Pool.assign(m_Columns.Pool);
+    m_Interned.clear();
+
+    m_Backing.reset();
+    Sync();
+}
+
+void unvm::VersionTable::Sync()
+{
+    m_Columns = {
+        .Key = m_Key,
+        .Version = m_Version,
+        .Date = m_Date,
+        .Files = m_Files,
+        .NPM = m_NPM,
+        .V8 = m_V8,
+        .UV = m_UV,
+        .ZLib = m_ZLib,
+        .OpenSSL = m_OpenSSL,
+        .LTS = m_LTS,
+        .Modules = m_Modules,
+        .Security = m_Security,
+        .Pool = m_Pool,
+    };
+}
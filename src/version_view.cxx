@@ -0,0 +1,80 @@
+#include <unvm/version.hxx>
+
+#include <numeric>
+
+unvm::VersionView::Iterator::Iterator(const VersionView *view, const size_t position)
+    : m_View(view),
+      m_Position(position)
+{
+}
+
+unvm::VersionEntry unvm::VersionView::Iterator::operator*() const
+{
+    return (*m_View)[m_Position];
+}
+
+unvm::VersionView::Iterator &unvm::VersionView::Iterator::operator++()
+{
+    ++m_Position;
+    return *this;
+}
+
+unvm::VersionView::Iterator unvm::VersionView::Iterator::operator++(int)
+{
+    auto copy = *this;
+    ++m_Position;
+    return copy;
+}
+
+unvm::VersionView::VersionView(std::shared_ptr<const VersionTable> table)
+    : m_Table(std::move(table)),
+      m_Rows(m_Table->Size())
+{
+    std::iota(m_Rows.begin(), m_Rows.end(), 0u);
+}
+
+unvm::VersionView::VersionView(std::shared_ptr<const VersionTable> table, std::vector<uint32_t> rows)
+    : m_Table(std::move(table)),
+      m_Rows(std::move(rows))
+{
+}
+
+const unvm::VersionTable &unvm::VersionView::Table() const
+{
+    return *m_Table;
+}
+
+std::span<const uint32_t> unvm::VersionView::Rows() const
+{
+    return m_Rows;
+}
+
+size_t unvm::VersionView::Size() const
+{
+    return m_Rows.size();
+}
+
+bool unvm::VersionView::Empty() const
+{
+    return m_Rows.empty();
+}
+
+unvm::VersionEntry unvm::VersionView::operator[](const size_t position) const
+{
+    return { m_Table.get(), m_Rows[position] };
+}
+
+unvm::VersionEntry unvm::VersionView::Entry(const uint32_t row) const
+{
+    return { m_Table.get(), row };
+}
+
+unvm::VersionView::Iterator unvm::VersionView::begin() const
+{
+    return { this, 0 };
+}
+
+unvm::VersionView::Iterator unvm::VersionView::end() const
+{
+    return { this, m_Rows.size() };
+}
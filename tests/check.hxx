@@ -0,0 +1,17 @@
+#pragma once
+
+#include <iostream>
+
+/**
+ * Fail the test function, which returns int, if the condition does not hold.
+ */
+#define CHECK(CONDITION)                                                                             \
+    do                                                                                               \
+    {                                                                                                \
+        if (!(CONDITION))                                                                            \
+        {                                                                                            \
+            std::cerr << __FILE__ << ':' << __LINE__ << ": check failed: " #CONDITION << std::endl;  \
+            return 1;                                                                                \
+        }                                                                                            \
+    }                                                                                                \
+    while (false)
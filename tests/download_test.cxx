@@ -0,0 +1,162 @@
+#include "check.hxx"
+#include "server.hxx"
+
+#include <unvm/http/http.hxx>
+
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <regex>
+
+static constexpr auto etag = "\"v1\"";
+
+/**
+ * Content that differs at every offset, so a range written to the wrong place shows.
+ */
+static std::string make_blob(const size_t size)
+{
+    std::mt19937 engine(25);
+
+    std::string blob(size, '\0');
+    for (auto &c : blob)
+    {
+        c = static_cast<char>(engine());
+    }
+
+    return blob;
+}
+
+static std::string read_file(const std::filesystem::path &path)
+{
+    std::ifstream stream(path, std::ios::binary);
+    return { std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>() };
+}
+
+/**
+ * Serves the blob at /blob, and a redirect to it at /moved. If ranges is set, range requests are answered with 206,
+ * and the first range that starts at cut_offset is cut off halfway through.
+ */
+struct BlobHandler
+{
+    const std::string &blob;
+    bool ranges;
+    uint64_t cut_offset = ~uint64_t();
+
+    std::atomic_uint &range_count;
+    std::atomic_bool &cut;
+
+    test::Response operator()(const test::Request &request) const
+    {
+        if (request.Path == "/moved")
+        {
+            return { .Status = 302, .Reason = "Found", .Headers = { { "Location", "/blob" } } };
+        }
+
+        if (request.Path != "/blob")
+        {
+            return { .Status = 404, .Reason = "Not Found" };
+        }
+
+        std::smatch match;
+
+        const auto range = request.Headers.find("range");
+        const auto if_range = request.Headers.find("if-range");
+
+        if (!ranges
+            || range == request.Headers.end()
+            || (if_range != request.Headers.end() && if_range->second != etag)
+            || !std::regex_match(range->second, match, std::regex(R"(bytes=(\d+)-(\d+))")))
+        {
+            return { .Headers = { { "ETag", etag } }, .Body = blob };
+        }
+
+        const auto first = std::stoull(match[1]);
+        const auto last = std::min<uint64_t>(std::stoull(match[2]), blob.size() - 1);
+
+        ++range_count;
+
+        test::Response response
+        {
+            .Status = 206,
+            .Reason = "Partial Content",
+            .Headers =
+            {
+                { "ETag", etag },
+                { "Content-Range", std::format("bytes {}-{}/{}", first, last, blob.size()) },
+            },
+            .Body = blob.substr(first, last - first + 1),
+        };
+
+        if (first == cut_offset && !cut.exchange(true))
+        {
+            response.Cut = response.Body.size() / 2;
+        }
+
+        return response;
+    }
+};
+
+/**
+ * A file fetched in ranges over several connections is reassembled in order, also if one of the connections breaks,
+ * and a server without range support still results in the whole file.
+ */
+int main()
+{
+    char directory[] = "/tmp/unvm-test-XXXXXX";
+    CHECK(mkdtemp(directory));
+
+    setenv("XDG_CONFIG_HOME", directory, 1);
+
+    const auto path = std::filesystem::path(directory) / "blob.bin";
+
+    // a little more than four ranges, so the last one is short
+    const auto blob = make_blob((9 << 20) + 123);
+
+    unvm::http::HttpClient client;
+
+    for (const auto ranges : { true, false })
+    {
+        std::atomic_uint range_count{};
+        std::atomic_bool cut{};
+
+        const test::Server server(
+            BlobHandler
+            {
+                .blob = blob,
+                .ranges = ranges,
+                .cut_offset = 4 << 20,
+                .range_count = range_count,
+                .cut = cut,
+            });
+
+        const auto url = std::format("http://127.0.0.1:{}/moved", server.Port());
+
+        unvm::http::HttpResponse response{};
+        if (auto res = unvm::http::Download(client, unvm::http::ParseURL(url), path, response); !res)
+        {
+            std::cerr << res.error() << std::endl;
+            return 1;
+        }
+
+        CHECK(read_file(path) == blob);
+
+        if (ranges)
+        {
+            CHECK(response.StatusCode == unvm::http::HttpStatusCode::PartialContent);
+            CHECK(cut);
+            // five ranges, and the one that broke once more
+            CHECK(range_count == 6);
+        }
+        else
+        {
+            CHECK(response.StatusCode == unvm::http::HttpStatusCode::OK);
+            CHECK(range_count == 0);
+        }
+    }
+
+    std::filesystem::remove_all(directory);
+    return 0;
+}
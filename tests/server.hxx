@@ -0,0 +1,368 @@
+#pragma once
+
+#include <openssl/err.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace test
+{
+    struct Request
+    {
+        std::string Method;
+        std::string Path;
+        std::map<std::string, std::string> Headers;
+    };
+
+    struct Response
+    {
+        int Status = 200;
+        std::string Reason = "OK";
+        std::vector<std::pair<std::string, std::string>> Headers;
+        std::string Body;
+        // close the connection after sending this many bytes of the body, as if it broke
+        size_t Cut = std::string::npos;
+    };
+
+    using Handler = std::function<Response(const Request &)>;
+
+    /**
+     * Self-signed certificate for localhost, generated on the fly, and a server context using it. The PEM is what a
+     * client has to trust to connect.
+     */
+    class Certificate
+    {
+    public:
+        Certificate()
+        {
+            m_Key = EVP_EC_gen("P-256");
+
+            const auto x509 = X509_new();
+            X509_set_version(x509, 2);
+            ASN1_INTEGER_set(X509_get_serialNumber(x509), 1);
+            X509_gmtime_adj(X509_getm_notBefore(x509), -60);
+            X509_gmtime_adj(X509_getm_notAfter(x509), 60 * 60);
+            X509_set_pubkey(x509, m_Key);
+
+            const auto name = X509_get_subject_name(x509);
+            const auto common_name = reinterpret_cast<const uint8_t *>("localhost");
+            X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, common_name, -1, -1, 0);
+            X509_set_issuer_name(x509, name);
+
+            X509V3_CTX context;
+            X509V3_set_ctx_nodb(&context);
+            X509V3_set_ctx(&context, x509, x509, nullptr, nullptr, 0);
+
+            for (auto [id, value] : {
+                     std::pair{ NID_basic_constraints, "critical,CA:TRUE" },
+                     std::pair{ NID_subject_alt_name, "DNS:localhost,IP:127.0.0.1" },
+                 })
+            {
+                const auto extension = X509V3_EXT_conf_nid(nullptr, &context, id, value);
+                X509_add_ext(x509, extension, -1);
+                X509_EXTENSION_free(extension);
+            }
+
+            X509_sign(x509, m_Key, EVP_sha256());
+
+            const auto bio = BIO_new(BIO_s_mem());
+            PEM_write_bio_X509(bio, x509);
+
+            char *data;
+            const auto size = BIO_get_mem_data(bio, &data);
+            m_Pem.assign(data, size);
+            BIO_free(bio);
+
+            m_Context = SSL_CTX_new(TLS_server_method());
+            SSL_CTX_use_certificate(m_Context, x509);
+            SSL_CTX_use_PrivateKey(m_Context, m_Key);
+
+            X509_free(x509);
+        }
+
+        ~Certificate()
+        {
+            SSL_CTX_free(m_Context);
+            EVP_PKEY_free(m_Key);
+        }
+
+        Certificate(const Certificate &) = delete;
+        Certificate &operator=(const Certificate &) = delete;
+
+        [[nodiscard]] std::span<const uint8_t> Pem() const
+        {
+            return { reinterpret_cast<const uint8_t *>(m_Pem.data()), m_Pem.size() };
+        }
+
+        [[nodiscard]] SSL_CTX *Context() const
+        {
+            return m_Context;
+        }
+
+    private:
+        EVP_PKEY *m_Key{};
+        SSL_CTX *m_Context{};
+        std::string m_Pem;
+    };
+
+    /**
+     * HTTP/1.1 server on an ephemeral port of 127.0.0.1, optionally over TLS. Every connection is served on a thread of
+     * its own and kept alive until the client closes it.
+     */
+    class Server
+    {
+    public:
+        explicit Server(Handler handler, SSL_CTX *tls = {})
+            : m_Handler(std::move(handler)),
+              m_TLS(tls)
+        {
+            m_Listener = socket(AF_INET, SOCK_STREAM, 0);
+
+            sockaddr_in address{};
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+            bind(m_Listener, reinterpret_cast<sockaddr *>(&address), sizeof(address));
+            listen(m_Listener, 16);
+
+            socklen_t length = sizeof(address);
+            getsockname(m_Listener, reinterpret_cast<sockaddr *>(&address), &length);
+            m_Port = ntohs(address.sin_port);
+
+            m_Thread = std::thread(&Server::Accept, this);
+        }
+
+        ~Server()
+        {
+            m_Stop = true;
+            shutdown(m_Listener, SHUT_RDWR);
+            close(m_Listener);
+            m_Thread.join();
+
+            std::lock_guard lock(m_Mutex);
+            for (const auto fd : m_Clients)
+            {
+                shutdown(fd, SHUT_RDWR);
+            }
+
+            for (auto &thread : m_Workers)
+            {
+                thread.join();
+            }
+
+            // closed only once all workers are done, so no descriptor is reused while it may still be shut down
+            for (const auto fd : m_Clients)
+            {
+                close(fd);
+            }
+        }
+
+        Server(const Server &) = delete;
+        Server &operator=(const Server &) = delete;
+
+        [[nodiscard]] uint16_t Port() const
+        {
+            return m_Port;
+        }
+
+        [[nodiscard]] unsigned Connections() const
+        {
+            return m_Connections;
+        }
+
+        /**
+         * Number of TLS connections that resumed a session instead of doing a full handshake.
+         */
+        [[nodiscard]] unsigned Resumed() const
+        {
+            return m_Resumed;
+        }
+
+    private:
+        void Accept()
+        {
+            while (!m_Stop)
+            {
+                const auto fd = accept(m_Listener, nullptr, nullptr);
+                if (fd < 0)
+                {
+                    continue;
+                }
+
+                ++m_Connections;
+
+                std::lock_guard lock(m_Mutex);
+                m_Clients.push_back(fd);
+                m_Workers.emplace_back(&Server::Serve, this, fd);
+            }
+        }
+
+        void Serve(const int fd)
+        {
+            SSL *ssl{};
+
+            if (m_TLS)
+            {
+                ssl = SSL_new(m_TLS);
+                SSL_set_fd(ssl, fd);
+
+                if (SSL_accept(ssl) <= 0)
+                {
+                    SSL_free(ssl);
+                    return;
+                }
+
+                if (SSL_session_reused(ssl))
+                {
+                    ++m_Resumed;
+                }
+            }
+
+            auto read = [&](char *buffer, const int size)
+            {
+                return ssl ? SSL_read(ssl, buffer, size) : static_cast<int>(recv(fd, buffer, size, 0));
+            };
+
+            auto write = [&](const std::string &data)
+            {
+                for (size_t offset = 0; offset < data.size();)
+                {
+                    const auto size = static_cast<int>(data.size() - offset);
+                    const auto count = ssl
+                                           ? SSL_write(ssl, data.data() + offset, size)
+                                           : static_cast<int>(send(fd, data.data() + offset, size, MSG_NOSIGNAL));
+                    if (count <= 0)
+                    {
+                        return false;
+                    }
+
+                    offset += count;
+                }
+
+                return true;
+            };
+
+            std::string pending;
+
+            for (;;)
+            {
+                size_t end;
+                while ((end = pending.find("\r\n\r\n")) == std::string::npos)
+                {
+                    char buffer[4096];
+                    const auto count = read(buffer, sizeof(buffer));
+                    if (count <= 0)
+                    {
+                        break;
+                    }
+
+                    pending.append(buffer, count);
+                }
+
+                if (end == std::string::npos)
+                {
+                    break;
+                }
+
+                auto request = Parse(pending.substr(0, end));
+                pending.erase(0, end + 4);
+
+                auto response = m_Handler(request);
+
+                auto packet = std::format("HTTP/1.1 {} {}\r\n", response.Status, response.Reason);
+                for (auto &[key, value] : response.Headers)
+                {
+                    packet += std::format("{}: {}\r\n", key, value);
+                }
+
+                packet += std::format("Content-Length: {}\r\n\r\n", response.Body.size());
+                packet.append(response.Body, 0, response.Cut);
+
+                if (!write(packet) || response.Cut < response.Body.size())
+                {
+                    break;
+                }
+            }
+
+            if (ssl)
+            {
+                SSL_shutdown(ssl);
+                SSL_free(ssl);
+            }
+
+            shutdown(fd, SHUT_RDWR);
+        }
+
+        static Request Parse(const std::string &block)
+        {
+            Request request;
+
+            size_t begin = 0;
+            for (auto first = true; begin < block.size(); first = false)
+            {
+                auto end = block.find("\r\n", begin);
+                if (end == std::string::npos)
+                {
+                    end = block.size();
+                }
+
+                const auto line = block.substr(begin, end - begin);
+                begin = end + 2;
+
+                if (first)
+                {
+                    const auto space = line.find(' ');
+                    request.Method = line.substr(0, space);
+                    request.Path = line.substr(space + 1, line.find(' ', space + 1) - space - 1);
+                    continue;
+                }
+
+                if (const auto colon = line.find(':'); colon != std::string::npos)
+                {
+                    auto key = line.substr(0, colon);
+                    for (auto &c : key)
+                    {
+                        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+                    }
+
+                    request.Headers[key] = line.substr(line.find_first_not_of(' ', colon + 1));
+                }
+            }
+
+            return request;
+        }
+
+        Handler m_Handler;
+        SSL_CTX *m_TLS;
+
+        int m_Listener;
+        uint16_t m_Port;
+
+        std::atomic_bool m_Stop{};
+        std::atomic_uint m_Connections{};
+        std::atomic_uint m_Resumed{};
+
+        std::thread m_Thread;
+
+        std::mutex m_Mutex;
+        std::vector<int> m_Clients;
+        std::vector<std::thread> m_Workers;
+    };
+}
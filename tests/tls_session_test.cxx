@@ -0,0 +1,90 @@
+#include "check.hxx"
+#include "server.hxx"
+
+#include <unvm/data.hxx>
+#include <unvm/http/http.hxx>
+
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+
+#include <sys/stat.h>
+
+/**
+ * Fetch the url with a client of its own, like a separate process would.
+ */
+static toolkit::result<std::string> fetch(const std::span<const uint8_t> certificates, const std::string &url)
+{
+    unvm::http::HttpClient client(certificates);
+
+    std::stringstream body;
+
+    unvm::http::HttpRequest request
+    {
+        .Method = unvm::http::HttpMethod::Get,
+        .Location = unvm::http::ParseURL(url),
+    };
+    unvm::http::HttpResponse response
+    {
+        .Body = &body,
+    };
+
+    if (auto res = client.Fetch(std::move(request), response); !res)
+    {
+        return res;
+    }
+
+    if (!unvm::http::IsSuccess(response.StatusCode))
+    {
+        return toolkit::make_error("unexpected status {}.", static_cast<int>(response.StatusCode));
+    }
+
+    return body.str();
+}
+
+/**
+ * A full handshake stores its session in tls.cache, and a fresh client resumes it from there.
+ */
+int main()
+{
+    char directory[] = "/tmp/unvm-test-XXXXXX";
+    CHECK(mkdtemp(directory));
+
+    setenv("XDG_CONFIG_HOME", directory, 1);
+
+    const auto cache_path = std::filesystem::path(directory) / "unvm" / "tls.cache";
+    std::filesystem::create_directories(cache_path.parent_path());
+
+    const test::Certificate certificate;
+    const test::Server server(
+        [](const test::Request &request)
+        {
+            return test::Response{ .Body = "hello from " + request.Path };
+        },
+        certificate.Context());
+
+    const auto url = std::format("https://localhost:{}/session", server.Port());
+
+    // the bundled certificates do not include the test CA, so without the hook the server is rejected. this has to
+    // come first, as a stored session would be resumed without verifying the certificate again
+    std::string body;
+    CHECK(!fetch(unvm::data::cacert, url));
+    CHECK(!std::filesystem::exists(cache_path));
+
+    CHECK(fetch(certificate.Pem(), url) >> body);
+    CHECK(body == "hello from /session");
+    CHECK(server.Resumed() == 0);
+
+    struct stat st{};
+    CHECK(!stat(cache_path.c_str(), &st));
+    CHECK((st.st_mode & 0777) == 0600);
+
+    CHECK(fetch(certificate.Pem(), url) >> body);
+    CHECK(body == "hello from /session");
+    CHECK(server.Connections() == 3);
+    CHECK(server.Resumed() == 1);
+
+    std::filesystem::remove_all(directory);
+    return 0;
+}